@@ -2,20 +2,42 @@
 
 #include "TypeTableInfo.h"
 #include "NnsTableInfo.h"
+#include "DeclFilter.h"
+#include "FileTableInfo.h"
+#include "CommentAttacher.h"
+#include "ResultCache.h"
+#include "HeaderFragments.h"
+#include "TypeTableDedup.h"
+#include "ParallelTraversal.h"
+#include "ParallelSave.h"
+#include "TimeReport.h"
+#include "ConversionStats.h"
+#include "LibXMLUtil.h"
 #include "DeclarationsVisitor.h"
 
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Frontend/ASTConsumers.h"
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/Utils.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
 #include "clang/Tooling/Tooling.h"
 #include "clang/Driver/Options.h"
 #include "llvm/Option/OptTable.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Signals.h"
 
 #include <libxml/xmlsave.h>
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <iostream>
 #include <time.h>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 using namespace clang;
 using namespace clang::driver;
@@ -25,49 +47,561 @@ using namespace llvm;
 static cl::extrahelp CommonHelp(CommonOptionsParser::HelpMessage);
 static std::unique_ptr<opt::OptTable> Options(createDriverOptTable());
 
+static cl::opt<bool> OptDedupTypes("dedup-types",
+    cl::desc("merge the type table entries that are written identically"),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<std::string> OptHeaderFragments("header-fragments",
+    cl::desc("write the declarations from each header once to a fragment "
+             "in this directory (implies -reproducible)"),
+    cl::value_desc("directory"),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<unsigned> OptTraversalJobs("traversal-jobs",
+    cl::desc("convert the top-level declarations of a translation unit "
+             "in this many worker processes"),
+    cl::init(1),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<unsigned> OptPipelineJobs("pipeline-jobs",
+    cl::desc("convert the top-level declarations in up to this many "
+             "worker processes while parsing goes on"),
+    cl::init(0),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<unsigned> OptSaveJobs("save-jobs",
+    cl::desc("serialize the output in this many threads"),
+    cl::init(1),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<std::string> OptTimeReport("time-report",
+    cl::desc("print the wall-clock and CPU time of each phase to stderr"),
+    cl::value_desc("text|json"),
+    cl::ValueOptional,
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<bool> OptStats("stats",
+    cl::desc("print the numbers of AST nodes, XML elements and table "
+             "entries of each translation unit to stderr as JSON"),
+    cl::cat(CXX2XMLCategory));
+
+/*! \brief Returns the `<clangDecl>` of the translation unit. */
+static xmlNodePtr
+findTranslationUnitNode(xmlNodePtr rootNode) {
+  return findChild(findChild(rootNode, "clangAST"), "clangDecl");
+}
+
+/*!
+ * \brief Estimates the time `D` takes to convert by the length of its
+ * source.
+ */
+static size_t
+estimateWork(const SourceManager &SM, const Decl *D) {
+  const auto begin = SM.getExpansionLoc(D->getLocStart());
+  const auto end = SM.getExpansionLoc(D->getLocEnd());
+  if (begin.isInvalid() || end.isInvalid()
+      || SM.getFileID(begin) != SM.getFileID(end)) {
+    return 1;
+  }
+  const auto b = SM.getFileOffset(begin);
+  const auto e = SM.getFileOffset(end);
+  return e > b ? e - b + 1 : 1;
+}
+
+/*!
+ * \brief Returns the type of `D` (null if it has none), to tell whether
+ * the parser changed it.
+ */
+static const void *
+getTypeKey(const Decl *D) {
+  const auto VD = dyn_cast<ValueDecl>(D);
+  return VD ? VD->getType().getAsOpaquePtr() : nullptr;
+}
+
+/*! \brief The objects that convert a translation unit. */
+struct Converter {
+  explicit Converter(ASTContext &CXT)
+      : MC(CXT.createMangleContext()),
+        declfilter(CXT.getSourceManager()),
+        filetableinfo(CXT.getSourceManager()),
+        commentattacher(CXT),
+        inheritanceinfo(),
+        typetableinfo(MC, &inheritanceinfo, &declfilter),
+        nnstableinfo(MC, &typetableinfo) {
+  }
+
+  /*!
+   * \brief Converts `D` into the children of `parent`, or of a new
+   * child `childName` of `parent`.
+   */
+  void
+  traverse(Decl *D, xmlNodePtr parent, const char *childName = nullptr) {
+    DeclarationsVisitor DV(MC,
+        parent,
+        childName,
+        &typetableinfo,
+        &nnstableinfo,
+        &declfilter,
+        &filetableinfo,
+        &commentattacher);
+    DV.TraverseDecl(D);
+  }
+
+  MangleContext *MC;
+  DeclFilter declfilter;
+  FileTableInfo filetableinfo;
+  CommentAttacher commentattacher;
+  InheritanceInfo inheritanceinfo;
+  TypeTableInfo typetableinfo;
+  NnsTableInfo nnstableinfo;
+};
+
+static void
+exitOnWorkerFailure(const char *option) {
+  errs() << option << ": a worker process failed\n";
+  exit(1);
+}
+
+/*! \brief Registers the type or NNS a placeholder of a worker stands for. */
+static std::string
+registerPlaceholder(
+    Converter &C, const std::pair<const void *, bool> &placeholder) {
+  return placeholder.second
+      ? C.nnstableinfo.getNnsName(
+            static_cast<const NestedNameSpecifier *>(placeholder.first))
+      : C.typetableinfo.getTypeName(
+            QualType::getFromOpaquePtr(placeholder.first));
+}
+
+/*!
+ * \brief Converts `TU` with all its declarations excluded, and returns
+ * the `<clangDecl>` with the (open) type and NNS tables.
+ */
+static xmlNodePtr
+convertEmptyTranslationUnit(
+    Converter &C, TranslationUnitDecl *TU, xmlNodePtr rootNode) {
+  C.declfilter.exclude(std::unordered_set<const Decl *>(
+      TU->decls_begin(), TU->decls_end()));
+  C.traverse(TU, rootNode, "clangAST");
+  C.declfilter.exclude(std::unordered_set<const Decl *>());
+  const auto unitNode = findTranslationUnitNode(rootNode);
+  C.typetableinfo.pushTypeTableStack(
+      findChild(unitNode, "xcodemlTypeTable"));
+  C.nnstableinfo.pushNnsTableStack(
+      findChild(unitNode, "xcodemlNnsTable"));
+  return unitNode;
+}
+
+/*!
+ * \brief Converts the translation unit with `-traversal-jobs` worker
+ * processes (see ParallelTraversal.h); the result is the same as that
+ * of a sequential run.
+ */
+static void
+traverseInParallel(
+    Converter &C, TranslationUnitDecl *TU, xmlNodePtr rootNode) {
+  const auto &SM = TU->getASTContext().getSourceManager();
+  const std::vector<const Decl *> decls(TU->decls_begin(), TU->decls_end());
+  std::vector<size_t> weights;
+  for (const auto D : decls) {
+    weights.push_back(estimateWork(SM, D));
+  }
+  const auto begins = partitionByWeight(weights, OptTraversalJobs);
+
+  std::vector<std::string> outputs;
+  const auto work = [&](unsigned k) {
+    std::unordered_set<const Decl *> excluded(decls.begin(), decls.end());
+    for (size_t i = begins[k]; i < begins[k + 1]; ++i) {
+      excluded.erase(decls[i]);
+    }
+    C.declfilter.exclude(std::move(excluded));
+    C.typetableinfo.enablePlaceholderNames();
+    ConversionStats::takeNodeCounts();
+    C.traverse(TU, rootNode, "clangAST");
+
+    TraversalResult result;
+    result.names = C.typetableinfo.getPlaceholderNames();
+    result.filterCounts = C.declfilter.getCounts();
+    // The parent visits the translation unit itself.
+    for (const auto &count : ConversionStats::takeNodeCounts()) {
+      if (count.first != "Decl:TranslationUnit") {
+        result.nodeCounts.push_back(count);
+      }
+    }
+    // The elements of the declarations follow the tables, and the
+    // elements before them are also in the translation unit of the
+    // parent.
+    const auto nnsTable = findChild(
+        findTranslationUnitNode(rootNode), "xcodemlNnsTable");
+    for (auto child = nnsTable->next; child; child = child->next) {
+      appendTree(child, result.trees);
+    }
+    return encodeTraversalResult(result);
+  };
+  if (!runWorkers(begins.size() - 1, work, outputs)) {
+    exitOnWorkerFailure("-traversal-jobs");
+  }
+
+  // Register the types and NNS in the order of the workers, which is
+  // the order in which a sequential run registers them.
+  const auto unitNode = convertEmptyTranslationUnit(C, TU, rootNode);
+  std::vector<TraversalResult> results(outputs.size());
+  std::vector<std::vector<std::string>> names(outputs.size());
+  for (size_t k = 0; k < outputs.size(); ++k) {
+    if (!decodeTraversalResult(outputs[k], results[k])) {
+      exitOnWorkerFailure("-traversal-jobs");
+    }
+    outputs[k].clear();
+    for (const auto &placeholder : results[k].names) {
+      names[k].push_back(registerPlaceholder(C, placeholder));
+    }
+  }
+  C.typetableinfo.popTypeTableStack();
+  C.nnstableinfo.popNnsTableStack();
+
+  for (size_t k = 0; k < results.size(); ++k) {
+    if (!appendTrees(unitNode, results[k].trees, names[k])) {
+      exitOnWorkerFailure("-traversal-jobs");
+    }
+    C.declfilter.addCounts(results[k].filterCounts);
+    ConversionStats::addNodeCounts(results[k].nodeCounts);
+  }
+}
+
+/*!
+ * \brief Whether the parser may still change what `D` converts to
+ * after handing it over: a C++ class gets implicitly declared members
+ * and a template gets instantiations until the end of the translation
+ * unit, and a function declared with `auto` gets its return type when
+ * a definition is parsed.
+ */
+static bool
+mayChangeAfterParsing(const Decl *D) {
+  if (isa<CXXRecordDecl>(D) || isa<TemplateDecl>(D)) {
+    return true;
+  }
+  if (const auto FD = dyn_cast<FunctionDecl>(D)) {
+    const auto AT = FD->getReturnType()->getContainedAutoType();
+    if (AT && !AT->isDeduced()) {
+      return true;
+    }
+  }
+  if (const auto DC = dyn_cast<DeclContext>(D)) {
+    for (const auto child : DC->decls()) {
+      if (mayChangeAfterParsing(child)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/*!
+ * \brief Converts top-level declarations in worker processes while the
+ * parser goes on (`-pipeline-jobs`).
+ *
+ * The declarations handed over by the parser are collected into
+ * batches, and each batch is converted by a process forked at that
+ * moment, which sees the AST parsed so far. Like `-traversal-jobs`,
+ * the workers name types and NNS with placeholders; at the end of the
+ * translation unit the parent walks the declarations in order,
+ * registers the placeholders of each declaration converted by a
+ * worker and appends its elements, and converts the others itself.
+ * So the names and the tables are those of a sequential run, built
+ * from the complete AST.
+ */
+class Pipeline {
+public:
+  explicit Pipeline(ASTContext &CXT)
+      : SM(CXT.getSourceManager()),
+        workerConverter(CXT),
+        batch(),
+        batchWeight(0),
+        added(),
+        running(),
+        batches(),
+        batchTypes(),
+        outputs() {
+  }
+  Pipeline(const Pipeline &) = delete;
+  Pipeline &operator=(const Pipeline &) = delete;
+
+  ~Pipeline() {
+    for (auto &worker : running) {
+      std::string discarded;
+      finishWorker(worker, discarded);
+    }
+  }
+
+  void
+  add(Decl *D) {
+    if (D->getLexicalDeclContext() != D->getTranslationUnitDecl()
+        || mayChangeAfterParsing(D) || !added.insert(D).second) {
+      return; // converted at the end
+    }
+    batch.push_back(D);
+    batchWeight += estimateWork(SM, D);
+    if (batchWeight >= batchSize) {
+      startBatch();
+    }
+  }
+
+  /*! \brief Converts the translation unit with `C`. */
+  void
+  finish(Converter &C, TranslationUnitDecl *TU, xmlNodePtr rootNode) {
+    if (!batch.empty()) {
+      startBatch();
+    }
+    while (!running.empty()) {
+      finishOldest();
+    }
+    std::vector<std::vector<TraversalResult>> results(outputs.size());
+    std::unordered_map<const Decl *, std::pair<size_t, size_t>> where;
+    for (size_t k = 0; k < outputs.size(); ++k) {
+      if (!decodeTraversalResults(outputs[k], results[k])
+          || results[k].size() != batches[k].size()) {
+        exitOnWorkerFailure("-pipeline-jobs");
+      }
+      outputs[k].clear();
+      // A declaration whose type changed after the fork (which
+      // mayChangeAfterParsing did not foresee) is converted again, and
+      // so are the rest of its batch, whose placeholders may refer to
+      // its names.
+      for (size_t i = 0; i < batches[k].size(); ++i) {
+        if (getTypeKey(batches[k][i]) != batchTypes[k][i]) {
+          break;
+        }
+        where[batches[k][i]] = std::make_pair(k, i);
+      }
+    }
+
+    const auto unitNode = convertEmptyTranslationUnit(C, TU, rootNode);
+    std::vector<std::vector<std::string>> names(results.size());
+    std::vector<size_t> registered(results.size());
+    for (const auto D : TU->decls()) {
+      // as RecursiveASTVisitor does
+      if (isa<BlockDecl>(D) || isa<CapturedDecl>(D)) {
+        continue;
+      }
+      const auto iter = where.find(D);
+      if (iter == where.end()) {
+        C.traverse(D, unitNode);
+        continue;
+      }
+      const auto k = iter->second.first;
+      const auto i = iter->second.second;
+      // A placeholder may stand for a name registered by an earlier
+      // declaration of the batch.
+      for (; registered[k] <= i; ++registered[k]) {
+        for (const auto &placeholder : results[k][registered[k]].names) {
+          names[k].push_back(registerPlaceholder(C, placeholder));
+        }
+      }
+      if (!appendTrees(unitNode, results[k][i].trees, names[k])) {
+        exitOnWorkerFailure("-pipeline-jobs");
+      }
+      C.declfilter.addCounts(results[k][i].filterCounts);
+      ConversionStats::addNodeCounts(results[k][i].nodeCounts);
+    }
+    C.typetableinfo.popTypeTableStack();
+    C.nnstableinfo.popNnsTableStack();
+  }
+
+private:
+  /*! \brief The source length of a batch (see estimateWork). */
+  static const size_t batchSize = 64 * 1024;
+
+  void
+  startBatch() {
+    if (running.size() >= OptPipelineJobs) {
+      finishOldest();
+    }
+    Worker worker;
+    if (!startWorker([this]() { return convertBatch(); }, worker)) {
+      exitOnWorkerFailure("-pipeline-jobs");
+    }
+    running.push_back(worker);
+    batchTypes.emplace_back();
+    for (const auto D : batch) {
+      batchTypes.back().push_back(getTypeKey(D));
+    }
+    batches.push_back(std::move(batch));
+    batch.clear();
+    batchWeight = 0;
+  }
+
+  void
+  finishOldest() {
+    outputs.emplace_back();
+    if (!finishWorker(running.front(), outputs.back())) {
+      exitOnWorkerFailure("-pipeline-jobs");
+    }
+    running.pop_front();
+  }
+
+  /*! \brief Runs in a worker: converts each declaration of `batch`. */
+  std::string
+  convertBatch() {
+    auto &C = workerConverter;
+    C.typetableinfo.pushTypeTableStack(
+        xmlNewNode(nullptr, BAD_CAST "xcodemlTypeTable"));
+    C.nnstableinfo.pushNnsTableStack(
+        xmlNewNode(nullptr, BAD_CAST "xcodemlNnsTable"));
+    C.typetableinfo.enablePlaceholderNames();
+    const auto &log = C.typetableinfo.getPlaceholderNames();
+    ConversionStats::takeNodeCounts();
+
+    std::vector<TraversalResult> results;
+    for (const auto D : batch) {
+      const auto logSize = log.size();
+      const auto counts = C.declfilter.getCounts();
+      const auto parent = xmlNewNode(nullptr, BAD_CAST "clangAST");
+      C.traverse(D, parent);
+
+      TraversalResult result;
+      result.names.assign(log.begin() + logSize, log.end());
+      result.filterCounts = C.declfilter.getCounts();
+      for (size_t i = 0; i < counts.size(); ++i) {
+        result.filterCounts[i] -= counts[i];
+      }
+      result.nodeCounts = ConversionStats::takeNodeCounts();
+      for (auto child = parent->children; child; child = child->next) {
+        appendTree(child, result.trees);
+      }
+      xmlFreeNode(parent);
+      results.push_back(std::move(result));
+    }
+    return encodeTraversalResults(results);
+  }
+
+  const SourceManager &SM;
+  /*! copied into each worker, and never used by the parent */
+  Converter workerConverter;
+  std::vector<Decl *> batch;
+  size_t batchWeight;
+  std::unordered_set<const Decl *> added;
+  std::deque<Worker> running;
+  /*! the batches started so far */
+  std::vector<std::vector<Decl *>> batches;
+  /*! the getTypeKey of each declaration of `batches` at the fork */
+  std::vector<std::vector<const void *>> batchTypes;
+  /*! what the workers of `batches` returned, for those finished */
+  std::vector<std::string> outputs;
+};
+
 class XMLASTConsumer : public ASTConsumer {
   xmlNodePtr rootNode;
+  std::unique_ptr<Pipeline> pipeline;
 
 public:
-  explicit XMLASTConsumer(xmlNodePtr N) : rootNode(N){};
+  explicit XMLASTConsumer(xmlNodePtr N) : rootNode(N), pipeline(){};
+
+  virtual bool
+  HandleTopLevelDecl(DeclGroupRef DG) override {
+    if (OptPipelineJobs == 0) {
+      return true;
+    }
+    for (const auto D : DG) {
+      if (!pipeline) {
+        pipeline.reset(new Pipeline(D->getASTContext()));
+      }
+      pipeline->add(D);
+    }
+    return true;
+  }
 
   virtual void
   HandleTranslationUnit(ASTContext &CXT) override {
-    MangleContext *MC = CXT.createMangleContext();
-    InheritanceInfo inheritanceinfo;
-    InheritanceInfo *II = &inheritanceinfo;
-    TypeTableInfo typetableinfo(MC, II);
-    TypeTableInfo *TTI = &typetableinfo;
-    NnsTableInfo nnstableinfo(MC, TTI);
-    NnsTableInfo *NTI = &nnstableinfo;
-    DeclarationsVisitor DV(MC, rootNode, "clangAST", TTI, NTI);
-    Decl *D = CXT.getTranslationUnitDecl();
+    PhaseTimer timer("traversal");
+    Converter converter(CXT);
+    TranslationUnitDecl *D = CXT.getTranslationUnitDecl();
 
-    DV.TraverseDecl(D);
+    if (pipeline) {
+      pipeline->finish(converter, D, rootNode);
+    } else if (OptTraversalJobs > 1) {
+      traverseInParallel(converter, D, rootNode);
+    } else {
+      converter.traverse(D, rootNode, "clangAST");
+    }
+    converter.filetableinfo.emitFileTable(rootNode);
+    converter.declfilter.printStatistics(errs());
   }
-#if 0
-    virtual bool HandleTopLevelDecl(DeclGroupRef DG) override {
-        // We can check whether parsing should be continued or not
-        // at the time that each declaration parsing is done.
-        // default: true.
-        return true;
+};
+
+/*!
+ * \brief Collects every file a translation unit reads (including
+ * system headers) for ResultCache.
+ */
+class AllDependencyCollector : public DependencyCollector {
+public:
+  bool
+  needSystemDependencies() override {
+    return true;
+  }
+};
+
+/*!
+ * \brief Notes an expansion of `__DATE__`, `__TIME__` or
+ * `__TIMESTAMP__`, whose output ResultCache must not store.
+ */
+class TimeMacroDetector : public PPCallbacks {
+public:
+  explicit TimeMacroDetector(bool &expanded) : expanded(expanded) {
+  }
+
+  void
+  MacroExpands(const Token &MacroNameTok,
+      const MacroDefinition &,
+      SourceRange,
+      const MacroArgs *) override {
+    const auto name = MacroNameTok.getIdentifierInfo()->getName();
+    if (name == "__DATE__" || name == "__TIME__" || name == "__TIMESTAMP__") {
+      expanded = true;
     }
-#endif
+  }
+
+private:
+  bool &expanded;
 };
 
 class XMLASTDumpAction : public ASTFrontendAction {
 private:
   xmlDocPtr xmlDoc;
+  ResultCache *cache;
+  std::shared_ptr<AllDependencyCollector> dependencies;
+  /*! whether the translation unit expanded a time macro */
+  bool usesTime;
+  /*! the main file as written in the `file` attributes */
+  std::string mainFile;
+  std::vector<std::string> fragmentFiles;
 
 public:
+  explicit XMLASTDumpAction(ResultCache *RC = nullptr)
+      : cache(RC), usesTime(false){};
+
   bool
   BeginSourceFileAction(
       clang::CompilerInstance &CI, StringRef Filename) override {
-    (void)CI; // suppress warnings
+    if (cache) {
+      // The preprocessor already exists, so attach the collector to it
+      // directly (CI keeps it alive).
+      dependencies = std::make_shared<AllDependencyCollector>();
+      CI.addDependencyCollector(dependencies);
+      dependencies->attachToPreprocessor(CI.getPreprocessor());
+      CI.getPreprocessor().addPPCallbacks(
+          std::unique_ptr<PPCallbacks>(new TimeMacroDetector(usesTime)));
+    }
     xmlDoc = xmlNewDoc(BAD_CAST "1.0");
     xmlNodePtr rootnode = xmlNewNode(nullptr, BAD_CAST "Program");
     xmlDocSetRootElement(xmlDoc, rootnode);
 
+    mainFile = FileTableInfo::normalizeFileName(Filename);
+    if (OptReproducible) {
+      xmlNewProp(rootnode, BAD_CAST "source", BAD_CAST mainFile.c_str());
+      xmlNewProp(rootnode, BAD_CAST "language", BAD_CAST "C");
+      return true;
+    }
+
     char strftimebuf[BUFSIZ];
     time_t t = time(nullptr);
 
@@ -90,21 +624,160 @@ public:
     return C;
   }
 
+  void
+  ExecuteAction() override {
+    // ParseAST calls HandleTranslationUnit at the end, whose time is
+    // reported as the traversal.
+    PhaseTimer timer("parse");
+    ASTFrontendAction::ExecuteAction();
+  }
+
   void
   EndSourceFileAction(void) override {
     // int saveopt = XML_SAVE_FORMAT | XML_SAVE_NO_EMPTY;
-    int saveopt = XML_SAVE_FORMAT;
+    int saveopt = OptCompactOutput ? 0 : XML_SAVE_FORMAT;
+    if (OptDedupTypes) {
+      deduplicateTypeTable(xmlDocGetRootElement(xmlDoc));
+    }
+    if (!OptHeaderFragments.empty()) {
+      HeaderFragments fragments(OptHeaderFragments, saveopt);
+      if (!fragments.split(xmlDocGetRootElement(xmlDoc), mainFile)) {
+        errs() << "-header-fragments: cannot write to " << OptHeaderFragments
+               << "\n";
+        exit(1);
+      }
+      fragmentFiles = fragments.getFiles();
+    }
+    if (OptStats) {
+      ConversionStats::print(std::cerr, mainFile, xmlDoc);
+    }
+    if (cache) {
+      saveToCache(saveopt);
+      return;
+    }
+    PhaseTimer timer("save");
+    if (OptSaveJobs > 1) {
+      const auto chunks = saveDocument(xmlDoc, saveopt, OptSaveJobs);
+      xmlFreeDoc(xmlDoc);
+      fflush(stdout);
+      if (!writeChunks(fileno(stdout), chunks)) {
+        errs() << "cannot write the output\n";
+        exit(1);
+      }
+      return;
+    }
     xmlSaveCtxtPtr ctxt = xmlSaveToFilename("-", "UTF-8", saveopt);
     xmlSaveDoc(ctxt, xmlDoc);
     xmlSaveClose(ctxt);
     xmlFreeDoc(xmlDoc);
   }
+
+private:
+  /*!
+   * \brief Writes the document to stdout and passes it to the cache
+   * unless the translation unit has errors or expands a time macro.
+   */
+  void
+  saveToCache(int saveopt) {
+    std::string xml;
+    {
+      PhaseTimer timer("save");
+      for (const auto &chunk : saveDocument(xmlDoc, saveopt, OptSaveJobs)) {
+        xml += chunk;
+      }
+      xmlFreeDoc(xmlDoc);
+      fwrite(xml.data(), 1, xml.size(), stdout);
+    }
+
+    auto &CI = getCompilerInstance();
+    if (CI.getDiagnostics().hasErrorOccurred() || usesTime) {
+      return;
+    }
+    std::vector<std::string> files;
+    for (const auto &file : dependencies->getDependencies()) {
+      SmallString<256> path(file);
+      CI.getFileManager().makeAbsolutePath(path);
+      files.push_back(path.str());
+    }
+    // a hit is valid only while the fragments it refers to exist
+    for (const auto &file : fragmentFiles) {
+      SmallString<256> path(file);
+      CI.getFileManager().makeAbsolutePath(path);
+      files.push_back(path.str());
+    }
+    cache->addResult(files, xml);
+  }
 };
 
-int
-main(int argc, const char **argv) {
-  llvm::sys::PrintStackTraceOnErrorSignal();
-  CommonOptionsParser OptionsParser(argc, argv, CXX2XMLCategory);
+class XMLASTDumpActionFactory : public FrontendActionFactory {
+  ResultCache *cache;
+
+public:
+  explicit XMLASTDumpActionFactory(ResultCache *RC) : cache(RC){};
+
+  FrontendAction *
+  create() override {
+    return new XMLASTDumpAction(cache);
+  }
+};
+
+/*!
+ * \brief Converts the sources one by one, reusing the output of
+ * unchanged ones from the -cache-dir.
+ */
+static int
+runWithCache(CommonOptionsParser &OptionsParser, int argc, const char **argv) {
+  const auto &sources = OptionsParser.getSourcePathList();
+  std::vector<std::string> toolArgs;
+  for (int i = 1; i < argc; ++i) {
+    if (std::find(sources.begin(), sources.end(), argv[i]) == sources.end()) {
+      toolArgs.push_back(argv[i]);
+    }
+  }
+  std::vector<std::string> inputFiles;
+  if (!TypeTableInfo::getTypeNameMapFile().empty()) {
+    inputFiles.push_back(TypeTableInfo::getTypeNameMapFile());
+  }
+  ResultCache cache(argv[0], toolArgs, inputFiles);
+
+  int status = 0;
+  for (const auto &source : sources) {
+    const auto path = getAbsolutePath(source);
+    std::string command;
+    for (const auto &CC :
+        OptionsParser.getCompilations().getCompileCommands(path)) {
+      command += CC.Directory;
+      for (const auto &arg : CC.CommandLine) {
+        command += '\0';
+        command += arg;
+      }
+      command += '\n';
+    }
+    std::string xml;
+    if (cache.lookup(path, command, xml)) {
+      fwrite(xml.data(), 1, xml.size(), stdout);
+      continue;
+    }
+    const std::vector<std::string> paths{source};
+    ClangTool Tool(OptionsParser.getCompilations(), paths);
+    Tool.appendArgumentsAdjuster(
+        clang::tooling::getClangSyntaxOnlyAdjuster());
+    XMLASTDumpActionFactory Factory(&cache);
+    const int ret = Tool.run(&Factory);
+    cache.commit(ret == 0);
+    if (ret != 0) {
+      status = ret;
+    }
+  }
+  cache.finish();
+  return status;
+}
+
+static int
+run(CommonOptionsParser &OptionsParser, int argc, const char **argv) {
+  if (ResultCache::isEnabled()) {
+    return runWithCache(OptionsParser, argc, argv);
+  }
   ClangTool Tool(
       OptionsParser.getCompilations(), OptionsParser.getSourcePathList());
   Tool.appendArgumentsAdjuster(clang::tooling::getClangSyntaxOnlyAdjuster());
@@ -114,6 +787,54 @@ main(int argc, const char **argv) {
   return Tool.run(FrontendFactory.get());
 }
 
+int
+main(int argc, const char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal();
+  CommonOptionsParser OptionsParser(argc, argv, CXX2XMLCategory);
+  if (!OptHeaderFragments.empty()) {
+    if (FileTableInfo::getSelectedEncoding()
+        != FileTableInfo::Encoding::Attributes) {
+      errs() << "-header-fragments: requires -location-encoding=attributes\n";
+      return 1;
+    }
+    if (sys::fs::create_directories(OptHeaderFragments)) {
+      errs() << "-header-fragments: cannot create " << OptHeaderFragments
+             << "\n";
+      return 1;
+    }
+    // the names of types must not depend on the translation unit
+    OptReproducible = true;
+  }
+  if ((OptTraversalJobs > 1 || OptPipelineJobs > 0)
+      && FileTableInfo::getSelectedEncoding()
+          == FileTableInfo::Encoding::Table) {
+    // the file IDs would depend on the worker
+    errs() << "-traversal-jobs, -pipeline-jobs: cannot be used with "
+              "-location-encoding=table\n";
+    return 1;
+  }
+  if (OptTraversalJobs > 1 && OptPipelineJobs > 0) {
+    errs() << "-traversal-jobs: cannot be used with -pipeline-jobs\n";
+    return 1;
+  }
+  if (OptTimeReport != "" && OptTimeReport != "text"
+      && OptTimeReport != "json") {
+    errs() << "-time-report: unknown format " << OptTimeReport << "\n";
+    return 1;
+  }
+  if (OptStats) {
+    ConversionStats::enable();
+  }
+  if (OptTimeReport.getNumOccurrences() == 0) {
+    return run(OptionsParser, argc, argv);
+  }
+  TimeReport::enable();
+  const int ret = run(OptionsParser, argc, argv);
+  fflush(stdout);
+  TimeReport::print(std::cerr, OptTimeReport == "json");
+  return ret;
+}
+
 ///
 /// Local Variables:
 /// indent-tabs-mode: nil
@@ -0,0 +1,127 @@
+#include "XMLRAV.h"
+#include "clang/AST/RawCommentList.h"
+#include "clang/Basic/SourceManager.h"
+#include <algorithm>
+#include "CommentAttacher.h"
+
+using namespace clang;
+using namespace llvm;
+
+static cl::opt<bool> OptEmitComments("emit-comments",
+    cl::desc("emit documentation comments of declarations (default: true)"),
+    cl::init(true),
+    cl::cat(CXX2XMLCategory));
+
+namespace {
+
+/*!
+ * \brief Returns the location where clang looks for the comment of `D`.
+ *
+ * The same choice as `ASTContext::getRawCommentForDeclNoCache`.
+ */
+SourceLocation
+getDeclLocForCommentSearch(const Decl *D) {
+  if (isa<RedeclarableTemplateDecl>(D)
+      || isa<ClassTemplateSpecializationDecl>(D)) {
+    return D->getLocStart();
+  }
+  return D->getLocation();
+}
+
+} // namespace
+
+CommentAttacher::CommentAttacher(ASTContext &CXT)
+    : CXT(CXT), isLoaded(false), commentsByFile() {
+}
+
+const RawComment *
+CommentAttacher::getComment(const Decl *D) {
+  if (!OptEmitComments || !mayHaveComment(D)) {
+    return nullptr;
+  }
+  return CXT.getRawCommentForDeclNoCache(D);
+}
+
+bool
+CommentAttacher::mayHaveComment(const Decl *D) {
+  auto &SM = CXT.getSourceManager();
+  if (!isLoaded) {
+    isLoaded = true;
+    for (const auto RC : CXT.getRawCommentList().getComments()) {
+      const auto range = RC->getSourceRange();
+      const auto begin = SM.getDecomposedLoc(range.getBegin());
+      const auto end = SM.getDecomposedLoc(range.getEnd());
+      auto &comments = commentsByFile[begin.first.getHashValue()];
+      comments.ranges.push_back(
+          {begin.second, end.second, RC->isTrailingComment()});
+    }
+    for (auto &entry : commentsByFile) {
+      auto &ranges = entry.second.ranges;
+      std::sort(ranges.begin(),
+          ranges.end(),
+          [](const CommentRange &lhs, const CommentRange &rhs) {
+            return lhs.begin < rhs.begin;
+          });
+      entry.second.cursor = 0;
+    }
+  }
+  if (commentsByFile.empty() || D->isImplicit()) {
+    return false;
+  }
+
+  const auto loc = getDeclLocForCommentSearch(D);
+  if (loc.isInvalid()) {
+    return false;
+  }
+  if (!loc.isFileID()) {
+    // clang has its own rules for macros: let it decide.
+    return true;
+  }
+  const auto decomposed = SM.getDecomposedLoc(loc);
+  const auto iter = commentsByFile.find(decomposed.first.getHashValue());
+  if (iter == commentsByFile.end()) {
+    return false;
+  }
+  const unsigned offset = decomposed.second;
+  auto &ranges = iter->second.ranges;
+  auto &cursor = iter->second.cursor;
+
+  // move the cursor to the first comment at or after `offset`.
+  if (cursor > 0 && ranges[cursor - 1].begin >= offset) {
+    cursor = std::lower_bound(ranges.begin(),
+                 ranges.begin() + cursor,
+                 offset,
+                 [](const CommentRange &range, unsigned offset) {
+                   return range.begin < offset;
+                 })
+        - ranges.begin();
+  }
+  while (cursor < ranges.size() && ranges[cursor].begin < offset) {
+    ++cursor;
+  }
+
+  // a trailing comment after the declaration (`int x; ///< ...`)
+  if (cursor < ranges.size() && ranges[cursor].isTrailing) {
+    return true;
+  }
+  // a comment before the declaration, with no other declaration
+  // or preprocessor directive in between
+  if (cursor == 0) {
+    return false;
+  }
+  const auto &prev = ranges[cursor - 1];
+  bool invalid = false;
+  const StringRef buffer = SM.getBufferData(decomposed.first, &invalid);
+  if (invalid || prev.end > offset || offset > buffer.size()) {
+    return true;
+  }
+  const auto between = buffer.substr(prev.end, offset - prev.end);
+  return between.find_first_of(";{}#@") == StringRef::npos;
+}
+
+///
+/// Local Variables:
+/// indent-tabs-mode: nil
+/// c-basic-offset: 2
+/// End:
+///
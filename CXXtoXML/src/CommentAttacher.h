@@ -0,0 +1,54 @@
+#ifndef COMMENTATTACHER_H
+#define COMMENTATTACHER_H
+
+#include <unordered_map>
+#include <vector>
+
+/*!
+ * \brief Finds the documentation comments attached to declarations.
+ *
+ * `ASTContext::getRawCommentForDeclNoCache` searches the whole comment
+ * list of the translation unit for every declaration. This class
+ * sorts the comments by file once and keeps a cursor per file. The
+ * declarations arrive mostly in source order, so one merge pass over
+ * the two sequences rules out most declarations. Only the candidates
+ * are passed to clang, so the result is the same as clang's.
+ */
+class CommentAttacher {
+public:
+  CommentAttacher() = delete;
+  CommentAttacher(const CommentAttacher &) = delete;
+  CommentAttacher(CommentAttacher &&) = delete;
+  CommentAttacher &operator=(const CommentAttacher &) = delete;
+  CommentAttacher &operator=(CommentAttacher &&) = delete;
+
+  explicit CommentAttacher(clang::ASTContext &);
+
+  /*!
+   * \brief Returns the comment attached to `D`, or nullptr.
+   *
+   * Always returns nullptr when `-emit-comments=false`.
+   */
+  const clang::RawComment *getComment(const clang::Decl *D);
+
+private:
+  struct CommentRange {
+    unsigned begin;
+    unsigned end;
+    bool isTrailing;
+  };
+  struct FileComments {
+    /*! sorted by offset */
+    std::vector<CommentRange> ranges;
+    /*! the index of the first comment at or after the last query */
+    size_t cursor;
+  };
+
+  bool mayHaveComment(const clang::Decl *D);
+
+  clang::ASTContext &CXT;
+  bool isLoaded;
+  std::unordered_map<unsigned, FileComments> commentsByFile;
+};
+
+#endif /* !COMMENTATTACHER_H */
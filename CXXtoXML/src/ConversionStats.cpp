@@ -0,0 +1,141 @@
+#include <libxml/tree.h>
+#include <cstdio>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ConversionStats.h"
+#include "LibXMLUtil.h"
+
+bool ConversionStats::enabled = false;
+
+namespace {
+
+/*!
+ * Keyed by the addresses of the strings, which is cheap to look up; the
+ * strings are compared only when the counts are taken.
+ */
+std::map<std::pair<const char *, const char *>, size_t> visits;
+
+/*! the counts added from workers */
+std::map<std::string, size_t> addedVisits;
+
+struct DocumentCounts {
+  size_t elements = 0;
+  size_t attributes = 0;
+  std::map<std::string, size_t> typeTable;
+  size_t nnsTable = 0;
+};
+
+void
+countElements(xmlNodePtr node, DocumentCounts &counts) {
+  for (; node; node = node->next) {
+    if (node->type != XML_ELEMENT_NODE) {
+      continue;
+    }
+    ++counts.elements;
+    for (auto attr = node->properties; attr; attr = attr->next) {
+      ++counts.attributes;
+    }
+    if (isElement(node, "xcodemlTypeTable")
+        || isElement(node, "xcodemlNnsTable")) {
+      const bool isTypeTable = isElement(node, "xcodemlTypeTable");
+      for (auto entry = node->children; entry; entry = entry->next) {
+        if (entry->type != XML_ELEMENT_NODE) {
+          continue;
+        } else if (isTypeTable) {
+          ++counts.typeTable[reinterpret_cast<const char *>(entry->name)];
+        } else {
+          ++counts.nnsTable;
+        }
+      }
+    }
+    countElements(node->children, counts);
+  }
+}
+
+void
+printString(std::ostream &os, const std::string &s) {
+  os << '"';
+  for (const char c : s) {
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof buf, "\\u%04x", c);
+      os << buf;
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+} // namespace
+
+void
+ConversionStats::enable() {
+  enabled = true;
+}
+
+void
+ConversionStats::countNode(const char *category, const char *kind) {
+  ++visits[std::make_pair(category, kind)];
+}
+
+NodeCounts
+ConversionStats::takeNodeCounts() {
+  auto counts = std::move(addedVisits);
+  addedVisits.clear();
+  for (const auto &visit : visits) {
+    const auto key =
+        std::string(visit.first.first) + ":" + visit.first.second;
+    counts[key] += visit.second;
+  }
+  visits.clear();
+  return NodeCounts(counts.begin(), counts.end());
+}
+
+void
+ConversionStats::addNodeCounts(const NodeCounts &counts) {
+  for (const auto &count : counts) {
+    addedVisits[count.first] += count.second;
+  }
+}
+
+void
+ConversionStats::print(
+    std::ostream &os, const std::string &source, xmlDocPtr doc) {
+  DocumentCounts counts;
+  countElements(xmlDocGetRootElement(doc), counts);
+
+  os << "{\"source\": ";
+  printString(os, source);
+  os << ", \"astNodes\": {";
+  std::string category;
+  for (const auto &node : takeNodeCounts()) {
+    const auto colon = node.first.find(':');
+    const auto nodeCategory = node.first.substr(0, colon);
+    if (nodeCategory != category) {
+      os << (category.empty() ? "" : "}, ");
+      printString(os, nodeCategory);
+      os << ": {";
+    } else {
+      os << ", ";
+    }
+    category = nodeCategory;
+    printString(os, node.first.substr(colon + 1));
+    os << ": " << node.second;
+  }
+  os << (category.empty() ? "" : "}") << "}, \"xmlElements\": "
+     << counts.elements << ", \"xmlAttributes\": " << counts.attributes
+     << ", \"typeTable\": {";
+  for (auto iter = counts.typeTable.begin(); iter != counts.typeTable.end();
+       ++iter) {
+    os << (iter == counts.typeTable.begin() ? "" : ", ");
+    printString(os, iter->first);
+    os << ": " << iter->second;
+  }
+  os << "}, \"nnsTable\": " << counts.nnsTable << "}" << std::endl;
+}
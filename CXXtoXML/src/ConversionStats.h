@@ -0,0 +1,62 @@
+#ifndef CONVERSIONSTATS_H
+#define CONVERSIONSTATS_H
+
+#include <libxml/tree.h>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+ * \brief The numbers of AST nodes visited, keyed by "category:kind"
+ * (e.g. "Decl:Function"), in the order of the keys.
+ */
+using NodeCounts = std::vector<std::pair<std::string, size_t>>;
+
+/*!
+ * \brief The workload of each translation unit (`-stats`).
+ *
+ * The AST nodes are counted as DeclarationsVisitor visits them; the
+ * rest is counted in the document written for the translation unit.
+ */
+class ConversionStats {
+public:
+  static void enable();
+  static bool
+  isEnabled() {
+    return enabled;
+  }
+
+  /*!
+   * \brief Counts a visit of an AST node of `kind` in `category`.
+   *
+   * Both strings must live until the end of the run (string literals
+   * and the class names clang returns do).
+   */
+  static void countNode(const char *category, const char *kind);
+
+  /*!
+   * \brief Returns the nodes counted so far and starts counting from
+   * zero.
+   */
+  static NodeCounts takeNodeCounts();
+
+  /*! \brief Adds the counts of a worker of `-traversal-jobs`. */
+  static void addNodeCounts(const NodeCounts &counts);
+
+  /*!
+   * \brief Prints the statistics of the translation unit `source` as a
+   * line of JSON, and starts counting nodes from zero.
+   *
+   * Besides the nodes, it prints the numbers of elements and attributes
+   * in `doc`, of the entries of the type tables by element name, and of
+   * the entries of the NNS tables.
+   */
+  static void print(
+      std::ostream &os, const std::string &source, xmlDocPtr doc);
+
+private:
+  static bool enabled;
+};
+
+#endif /* !CONVERSIONSTATS_H */
@@ -0,0 +1,247 @@
+#include "XMLRAV.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Regex.h"
+#include "DeclFilter.h"
+#include <memory>
+
+using namespace clang;
+using namespace llvm;
+
+static cl::opt<bool> OptSkipSystemHeaders("skip-system-headers",
+    cl::desc("do not emit declarations located in system headers"),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<bool> OptPruneImplicit("prune-implicit",
+    cl::desc("do not emit implicit declarations that XcodeMLtoCXX ignores"),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<bool> OptTemplateInstantiations("template-instantiations",
+    cl::desc("emit implicit template instantiations "
+             "(default: primary templates only)"),
+    cl::cat(CXX2XMLCategory));
+
+static cl::list<std::string> OptExtract("extract",
+    cl::desc("emit only the file-scope declarations of these qualified "
+             "names (and the types they refer to)"),
+    cl::value_desc("name,..."),
+    cl::CommaSeparated,
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<std::string> OptExtractRegex("extract-regex",
+    cl::desc("emit only the file-scope declarations whose qualified names "
+             "match this regular expression"),
+    cl::value_desc("regex"),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<bool> OptFilterStats("filter-stats",
+    cl::desc("print the number of declarations removed by each rule"),
+    cl::cat(CXX2XMLCategory));
+
+namespace {
+
+const char *
+getRuleName(DeclFilter::Rule rule) {
+  switch (rule) {
+  case DeclFilter::Rule::SystemHeader: return "system-header";
+  case DeclFilter::Rule::Implicit: return "implicit";
+  case DeclFilter::Rule::Instantiation: return "instantiation";
+  case DeclFilter::Rule::NotSelected: return "not-selected";
+  }
+  llvm_unreachable("unknown rule");
+}
+
+/*!
+ * \brief Returns true if XcodeMLtoCXX discards `D` when `D` is implicit.
+ *
+ * Implicit fields must be kept: they hold anonymous structs and unions.
+ */
+bool
+isIgnoredWhenImplicit(const Decl *D) {
+  return isa<FunctionDecl>(D) || (isa<VarDecl>(D) && !isa<ParmVarDecl>(D))
+      || isa<TypedefNameDecl>(D) || isa<RecordDecl>(D);
+}
+
+/*! \brief Counts `D` and the declarations nested in it. */
+size_t
+countDecls(const Decl *D) {
+  size_t n = 1;
+  if (const auto DC = dyn_cast<DeclContext>(D)) {
+    for (const auto child : DC->decls()) {
+      n += countDecls(child);
+    }
+  }
+  return n;
+}
+
+template <typename TemplateDecl>
+size_t
+countImplicitInstantiations(const TemplateDecl *TD) {
+  size_t n = 0;
+  for (const auto spec : TD->specializations()) {
+    if (spec->getTemplateSpecializationKind() == TSK_ImplicitInstantiation) {
+      n += countDecls(spec);
+    }
+  }
+  return n;
+}
+
+} // namespace
+
+DeclFilter::DeclFilter(const SourceManager &SM)
+    : SM(SM),
+      extractRegex(),
+      excluded(),
+      removedDecls(),
+      removedSubtrees() {
+  if (!OptExtractRegex.empty()) {
+    extractRegex.reset(new Regex(OptExtractRegex));
+    std::string error;
+    if (!extractRegex->isValid(error)) {
+      errs() << "-extract-regex: " << error << "\n";
+      exit(1);
+    }
+  }
+}
+
+DeclFilter::~DeclFilter() = default;
+
+bool
+DeclFilter::shouldEmit(const Decl *D) {
+  if (isa<TranslationUnitDecl>(D)) {
+    return true;
+  }
+  if (excluded.count(D)) {
+    return false;
+  }
+  if (OptSkipSystemHeaders && isInSystemHeader(D)) {
+    count(Rule::SystemHeader, D);
+    return false;
+  }
+  if (OptPruneImplicit && D->isImplicit() && isIgnoredWhenImplicit(D)) {
+    count(Rule::Implicit, D);
+    return false;
+  }
+  if (!isSelected(D)) {
+    count(Rule::NotSelected, D);
+    return false;
+  }
+  if (!OptTemplateInstantiations && D->isCanonicalDecl()) {
+    // The traversal does not enter the instantiations;
+    // count them at their primary template.
+    size_t n = 0;
+    if (const auto CTD = dyn_cast<ClassTemplateDecl>(D)) {
+      n = countImplicitInstantiations(CTD);
+    } else if (const auto FTD = dyn_cast<FunctionTemplateDecl>(D)) {
+      n = countImplicitInstantiations(FTD);
+    }
+    if (n) {
+      removedDecls[static_cast<int>(Rule::Instantiation)] += n;
+      ++removedSubtrees[static_cast<int>(Rule::Instantiation)];
+    }
+  }
+  return true;
+}
+
+bool
+DeclFilter::shouldEmitMemberFunctions(const RecordDecl *RD) const {
+  return !(OptSkipSystemHeaders && isInSystemHeader(RD));
+}
+
+bool
+DeclFilter::shouldVisitTemplateInstantiations() {
+  return OptTemplateInstantiations;
+}
+
+void
+DeclFilter::exclude(std::unordered_set<const Decl *> decls) {
+  excluded = std::move(decls);
+}
+
+bool
+DeclFilter::isExcluded(const Decl *D) const {
+  return excluded.count(D);
+}
+
+std::vector<size_t>
+DeclFilter::getCounts() const {
+  std::vector<size_t> counts(removedDecls, removedDecls + numRules);
+  counts.insert(counts.end(), removedSubtrees, removedSubtrees + numRules);
+  return counts;
+}
+
+void
+DeclFilter::addCounts(const std::vector<size_t> &counts) {
+  assert(counts.size() == 2 * numRules);
+  for (int i = 0; i < numRules; ++i) {
+    removedDecls[i] += counts[i];
+    removedSubtrees[i] += counts[numRules + i];
+  }
+}
+
+void
+DeclFilter::printStatistics(raw_ostream &OS) const {
+  if (!OptFilterStats) {
+    return;
+  }
+  for (const auto rule : {Rule::SystemHeader,
+           Rule::Implicit,
+           Rule::Instantiation,
+           Rule::NotSelected}) {
+    const auto i = static_cast<int>(rule);
+    OS << "removed by " << getRuleName(rule) << ": " << removedDecls[i]
+       << " decls in " << removedSubtrees[i] << " subtrees\n";
+  }
+}
+
+bool
+DeclFilter::isInSystemHeader(const Decl *D) const {
+  const auto loc = D->getLocation();
+  if (loc.isInvalid()) {
+    // builtin declarations (e.g. `__builtin_va_list`) have no location.
+    return false;
+  }
+  return SM.isInSystemHeader(SM.getExpansionLoc(loc));
+}
+
+bool
+DeclFilter::isSelected(const Decl *D) const {
+  if (OptExtract.empty() && !extractRegex) {
+    return true;
+  }
+  if (!D->getLexicalDeclContext()->getRedeclContext()->isFileContext()) {
+    // members and locals follow their enclosing declaration.
+    return true;
+  }
+  if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D)) {
+    // always traversed: they may contain selected declarations.
+    return true;
+  }
+  const auto ND = dyn_cast<NamedDecl>(D);
+  if (!ND) {
+    return false;
+  }
+  const auto name = ND->getQualifiedNameAsString();
+  for (const auto &selected : OptExtract) {
+    // `A::f` selects the whole class `A`.
+    if (selected == name
+        || (selected.size() > name.size() + 2
+               && selected.compare(0, name.size(), name) == 0
+               && selected.compare(name.size(), 2, "::") == 0)) {
+      return true;
+    }
+  }
+  return extractRegex && extractRegex->match(name);
+}
+
+void
+DeclFilter::count(Rule rule, const Decl *D) {
+  removedDecls[static_cast<int>(rule)] += countDecls(D);
+  ++removedSubtrees[static_cast<int>(rule)];
+}
+
+///
+/// Local Variables:
+/// indent-tabs-mode: nil
+/// c-basic-offset: 2
+/// End:
+///
@@ -0,0 +1,96 @@
+#ifndef DECLFILTER_H
+#define DECLFILTER_H
+
+#include <unordered_set>
+#include <vector>
+
+namespace llvm {
+class Regex;
+}
+
+/*!
+ * \brief Decides which declarations of a translation unit are
+ * emitted as XML elements.
+ *
+ * A declaration that is not emitted is skipped together with its
+ * children. The types such a declaration defines are still registered
+ * in the type table on demand when emitted code refers to them.
+ */
+class DeclFilter {
+public:
+  /*! \brief The reasons for which a declaration is not emitted. */
+  enum class Rule {
+    /*! located in a system header (`-skip-system-headers`) */
+    SystemHeader,
+    /*! an implicit declaration XcodeMLtoCXX never prints
+     * (`-prune-implicit`) */
+    Implicit,
+    /*! an implicit template instantiation
+     * (unless `-template-instantiations`) */
+    Instantiation,
+    /*! a file-scope declaration not selected by `-extract` or
+     * `-extract-regex` */
+    NotSelected,
+  };
+  static const int numRules = 4;
+
+  DeclFilter() = delete;
+  DeclFilter(const DeclFilter &) = delete;
+  DeclFilter(DeclFilter &&) = delete;
+  DeclFilter &operator=(const DeclFilter &) = delete;
+  DeclFilter &operator=(DeclFilter &&) = delete;
+
+  explicit DeclFilter(const clang::SourceManager &);
+  ~DeclFilter();
+
+  /*!
+   * \brief Returns true if `D` should be emitted as `<clangDecl>`.
+   *
+   * Also counts the declarations removed by each rule.
+   */
+  bool shouldEmit(const clang::Decl *D);
+
+  /*!
+   * \brief Returns true if the member functions of `RD` should be listed
+   * in the `<symbols>` of its type table entry.
+   */
+  bool shouldEmitMemberFunctions(const clang::RecordDecl *RD) const;
+
+  /*!
+   * \brief Returns true if the AST traversal should enter implicit
+   * template instantiations.
+   */
+  static bool shouldVisitTemplateInstantiations();
+
+  /*!
+   * \brief Skips `decls` without counting them, so that a worker of
+   * `-traversal-jobs` emits only its share of the top-level
+   * declarations.
+   */
+  void exclude(std::unordered_set<const clang::Decl *> decls);
+
+  /*! \brief Returns true if `D` is one of the declarations `exclude`d. */
+  bool isExcluded(const clang::Decl *D) const;
+
+  /*! \brief Returns the counts printStatistics prints. */
+  std::vector<size_t> getCounts() const;
+
+  /*! \brief Adds the counts of a worker of `-traversal-jobs`. */
+  void addCounts(const std::vector<size_t> &counts);
+
+  /*! \brief Prints the number of declarations removed by each rule. */
+  void printStatistics(llvm::raw_ostream &) const;
+
+private:
+  bool isInSystemHeader(const clang::Decl *D) const;
+  bool isSelected(const clang::Decl *D) const;
+  void count(Rule, const clang::Decl *D);
+
+  const clang::SourceManager &SM;
+  std::unique_ptr<llvm::Regex> extractRegex;
+  std::unordered_set<const clang::Decl *> excluded;
+  size_t removedDecls[numRules];
+  size_t removedSubtrees[numRules];
+};
+
+#endif /* !DECLFILTER_H */
@@ -3,6 +3,10 @@
 #include "DeclarationsVisitor.h"
 #include "InheritanceInfo.h"
 #include "NnsTableInfo.h"
+#include "DeclFilter.h"
+#include "CommentAttacher.h"
+#include "StringEscape.h"
+#include "LibXMLUtil.h"
 #include "XcodeMlNameElem.h"
 #include "clang/Basic/Builtins.h"
 #include "clang/Lex/Lexer.h"
@@ -21,6 +25,17 @@ static cl::opt<bool> OptDisableDeclarations("disable-declarations",
     cl::desc("disable <globalDeclarations>, <declarations>"),
     cl::cat(CXX2XMLCategory));
 
+static cl::opt<unsigned> OptPackInitListThreshold("pack-init-list-threshold",
+    cl::desc("emit an initializer list of at least this many integer "
+             "literals as one <intConstantList> (0: never)"),
+    cl::init(0),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<bool> OptPruneRedundantSubtrees("prune-redundant-subtrees",
+    cl::desc("emit <TypeLoc> and <clangDeclarationNameInfo> only where "
+             "XcodeMLtoCXX reads them"),
+    cl::cat(CXX2XMLCategory));
+
 const char *
 DeclarationsVisitor::getVisitorName() const {
   return OptTraceDeclarations ? "Declarations" : nullptr;
@@ -37,6 +52,41 @@ getSpelling(clang::Expr *E, const clang::ASTContext &CXT) {
   return spelling.str();
 }
 
+/*!
+ * \brief Returns the values of the initializer list `ILE`, separated by
+ * spaces, if all of its elements are integer literals of one type.
+ *
+ * Implicit conversions of the elements are ignored, as the XcodeML
+ * lowering prints only the literals.
+ */
+bool
+packIntegerLiterals(const InitListExpr *ILE, QualType &T, std::string &out) {
+  const unsigned n = ILE->getNumInits();
+  if (n == 0) {
+    return false;
+  }
+  out.reserve(n * 4);
+  for (unsigned i = 0; i < n; ++i) {
+    const auto E = ILE->getInit(i);
+    const auto IL =
+        E ? dyn_cast<IntegerLiteral>(E->IgnoreImpCasts()) : nullptr;
+    if (!IL || IL->getValue().getBitWidth() > 64) {
+      return false;
+    }
+    if (i == 0) {
+      T = IL->getType();
+    } else if (IL->getType() != T) {
+      return false;
+    }
+    const auto &value = IL->getValue();
+    out += T->isSignedIntegerType() ? std::to_string(value.getSExtValue())
+                                    : std::to_string(value.getZExtValue());
+    out += ' ';
+  }
+  out.pop_back();
+  return true;
+}
+
 std::string
 unsignedToHexString(unsigned u) {
   std::stringstream ss;
@@ -165,37 +215,20 @@ DeclarationsVisitor::PreVisitStmt(Stmt *S) {
   if (auto SL = dyn_cast<StringLiteral>(S)) {
     StringRef Data = SL->getString();
     std::string literalAsString;
-    raw_string_ostream OS(literalAsString);
-
-    for (unsigned i = 0, e = Data.size(); i != e; ++i) {
-      unsigned char C = Data[i];
-      if (C == '"' || C == '\\') {
-        OS << '\\' << (char)C;
-        continue;
-      }
-      if (isprint(C)) {
-        OS << (char)C;
-        continue;
-      }
-      switch (C) {
-      case '\b': OS << "\\b"; break;
-      case '\f': OS << "\\f"; break;
-      case '\n': OS << "\\n"; break;
-      case '\r': OS << "\\r"; break;
-      case '\t': OS << "\\t"; break;
-      default:
-        OS << '\\';
-        OS << ((C >> 6) & 0x7) + '0';
-        OS << ((C >> 3) & 0x7) + '0';
-        OS << ((C >> 0) & 0x7) + '0';
-        break;
-      }
-    }
-    OS.str();
+    escapeStringLiteral(Data.data(), Data.size(), literalAsString);
     newProp("stringLiteral", literalAsString.c_str());
   }
 
   if (auto ILE = dyn_cast<InitListExpr>(S)) {
+    QualType T;
+    std::string values;
+    if (OptPackInitListThreshold != 0
+        && ILE->getNumInits() >= OptPackInitListThreshold
+        && packIntegerLiterals(ILE, T, values)) {
+      auto packed = addChild("intConstantList", values.c_str());
+      newProp("xcodemlType", typetableinfo->getTypeName(T).c_str(), packed);
+      return false;
+    }
     /* `InitListExpr` has two kinds of children, `SyntacticForm`
      * and `SemanticForm`. Do not traverse `SyntacticForm`,
      * otherwise it emits the elements twice.
@@ -257,6 +290,12 @@ DeclarationsVisitor::PreVisitType(QualType T) {
 
 bool
 DeclarationsVisitor::PreVisitTypeLoc(TypeLoc TL) {
+  if (OptPruneRedundantSubtrees && isElement(curNode, "TypeLoc")) {
+    // The components of a written type are described by
+    // xcodemlTypeTable; only the outermost TypeLoc (which holds the
+    // parameter declarations of a function) is read.
+    return false;
+  }
   newChild("TypeLoc");
   newProp("class", NameForTypeLoc(TL));
   const auto T = TL.getType();
@@ -302,6 +341,9 @@ DeclarationsVisitor::PreVisitDecl(Decl *D) {
   if (!D) {
     return true;
   }
+  if (declfilter && !declfilter->shouldEmit(D)) {
+    return false;
+  }
 
   // default: use the AST name simply.
   newChild("clangDecl");
@@ -310,7 +352,8 @@ DeclarationsVisitor::PreVisitDecl(Decl *D) {
 
   auto &CXT = mangleContext->getASTContext();
   auto &SM = CXT.getSourceManager();
-  if (auto RC = CXT.getRawCommentForDeclNoCache(D)) {
+  if (auto RC = commentattacher ? commentattacher->getComment(D)
+                                : CXT.getRawCommentForDeclNoCache(D)) {
     auto comment = static_cast<std::string>(RC->getRawText(SM));
     addChild("comment", comment.c_str());
   }
@@ -418,6 +461,11 @@ DeclarationsVisitor::PostVisitDecl(Decl *D) {
 
 bool
 DeclarationsVisitor::PreVisitDeclarationNameInfo(DeclarationNameInfo NI) {
+  if (OptPruneRedundantSubtrees
+      && !isElement(curNode, "clangStmt", "DeclRefExpr")) {
+    // Elsewhere the name element of the parent has the same information.
+    return false;
+  }
   DeclarationName DN = NI.getName();
 
   const auto name = NI.getAsString();
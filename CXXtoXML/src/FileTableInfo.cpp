@@ -0,0 +1,234 @@
+#include "XMLRAV.h"
+#include "XMLVisitorBase.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include <libxml/tree.h>
+#include <algorithm>
+#include <unistd.h>
+#include "FileTableInfo.h"
+
+using namespace clang;
+using namespace llvm;
+
+static cl::opt<std::string> OptLocationEncoding("location-encoding",
+    cl::desc("how to emit source locations: "
+             "attributes (file, lineno, column), "
+             "table (<fileTable> and loc), or none"),
+    cl::value_desc("attributes|table|none"),
+    cl::init("attributes"),
+    cl::cat(CXX2XMLCategory));
+
+namespace {
+
+FileTableInfo::Encoding
+getEncodingByName(const std::string &name) {
+  if (name == "attributes") {
+    return FileTableInfo::Encoding::Attributes;
+  } else if (name == "table") {
+    return FileTableInfo::Encoding::Table;
+  } else if (name == "none") {
+    return FileTableInfo::Encoding::None;
+  }
+  errs() << "-location-encoding: unknown encoding '" << name << "'\n";
+  exit(1);
+}
+
+/*!
+ * \brief Returns the offsets of the beginnings of lines in `buffer`.
+ *
+ * Line ends are recognized in the same way as
+ * `SourceManager::getLineNumber`: `\n`, `\r`, `\r\n` and `\n\r`.
+ */
+std::vector<unsigned>
+computeLineStarts(StringRef buffer) {
+  std::vector<unsigned> lineStarts;
+  lineStarts.push_back(0);
+  const char *const data = buffer.data();
+  const size_t size = buffer.size();
+  for (size_t i = 0; i < size; ++i) {
+    const char c = data[i];
+    if (c != '\n' && c != '\r') {
+      continue;
+    }
+    if (i + 1 < size && (data[i + 1] == '\n' || data[i + 1] == '\r')
+        && data[i + 1] != c) {
+      ++i;
+    }
+    lineStarts.push_back(i + 1);
+  }
+  return lineStarts;
+}
+
+} // namespace
+
+FileTableInfo::FileTableInfo(const SourceManager &SM)
+    : SM(SM),
+      encoding(getSelectedEncoding()),
+      lastFileID(),
+      lastFileCache(nullptr),
+      fileCaches(),
+      fileNames(),
+      idByPointer(),
+      idByName() {
+}
+
+FileTableInfo::Encoding
+FileTableInfo::getSelectedEncoding() {
+  return getEncodingByName(OptLocationEncoding);
+}
+
+bool
+FileTableInfo::resolve(SourceLocation Loc, ResolvedLoc &result) {
+  if (Loc.isInvalid()) {
+    return false;
+  }
+  const auto decomposed = SM.getDecomposedExpansionLoc(Loc);
+  const FileID FID = decomposed.first;
+  const unsigned offset = decomposed.second;
+  FileCache &cache = getFileCache(FID);
+  if (!cache.isCached) {
+    const PresumedLoc PLoc = SM.getPresumedLoc(Loc);
+    if (PLoc.isInvalid()) {
+      return false;
+    }
+    result.filename = PLoc.getFilename();
+    result.line = PLoc.getLine();
+    result.column = PLoc.getColumn();
+    return true;
+  }
+
+  const auto &starts = cache.lineStarts;
+  size_t line = cache.lastLine;
+  if (offset >= starts[line]) {
+    // forward scan for a nearby line, then fall back to binary search.
+    const size_t limit = std::min(line + 8, starts.size());
+    while (line + 1 < limit && starts[line + 1] <= offset) {
+      ++line;
+    }
+    if (line + 1 == limit && limit < starts.size()
+        && starts[limit] <= offset) {
+      line = std::upper_bound(starts.begin() + limit, starts.end(), offset)
+          - starts.begin() - 1;
+    }
+  } else {
+    line = std::upper_bound(starts.begin(), starts.begin() + line, offset)
+        - starts.begin() - 1;
+  }
+  cache.lastLine = line;
+  result.filename = cache.filename;
+  result.line = line + 1;
+  result.column = offset - starts[line] + 1;
+  return true;
+}
+
+void
+FileTableInfo::setLocation(xmlNodePtr N, SourceLocation Loc) {
+  if (encoding == Encoding::None) {
+    return;
+  }
+  ResolvedLoc RLoc;
+  if (!resolve(Loc, RLoc)) {
+    return;
+  }
+  const int id = getFileId(RLoc.filename);
+  const auto line = std::to_string(RLoc.line);
+  const auto column = std::to_string(RLoc.column);
+  if (encoding == Encoding::Table) {
+    const auto loc = std::to_string(id) + ":" + line + ":" + column;
+    xmlNewProp(N, BAD_CAST "loc", BAD_CAST loc.c_str());
+    return;
+  }
+  xmlNewProp(N, BAD_CAST "column", BAD_CAST column.c_str());
+  xmlNewProp(N, BAD_CAST "lineno", BAD_CAST line.c_str());
+  xmlNewProp(N, BAD_CAST "file", BAD_CAST fileNames[id].c_str());
+}
+
+void
+FileTableInfo::emitFileTable(xmlNodePtr Parent) const {
+  if (encoding != Encoding::Table) {
+    return;
+  }
+  const auto fileTable =
+      xmlNewChild(Parent, nullptr, BAD_CAST "fileTable", nullptr);
+  for (size_t id = 0; id < fileNames.size(); ++id) {
+    const auto file =
+        xmlNewChild(fileTable, nullptr, BAD_CAST "file", nullptr);
+    xmlNewProp(file, BAD_CAST "id", BAD_CAST std::to_string(id).c_str());
+    xmlNewProp(file, BAD_CAST "name", BAD_CAST fileNames[id].c_str());
+  }
+}
+
+FileTableInfo::FileCache &
+FileTableInfo::getFileCache(FileID FID) {
+  if (lastFileCache && FID == lastFileID) {
+    return *lastFileCache;
+  }
+  const auto result = fileCaches.emplace(FID.getHashValue(), FileCache());
+  FileCache &cache = result.first->second;
+  if (result.second) {
+    cache.isCached = false;
+    cache.filename = nullptr;
+    cache.lastLine = 0;
+    bool invalid = false;
+    const auto &entry = SM.getSLocEntry(FID, &invalid);
+    if (!invalid && entry.isFile() && !entry.getFile().hasLineDirectives()) {
+      const StringRef buffer = SM.getBufferData(FID, &invalid);
+      const PresumedLoc PLoc =
+          SM.getPresumedLoc(SM.getLocForStartOfFile(FID));
+      if (!invalid && PLoc.isValid()) {
+        cache.isCached = true;
+        cache.filename = PLoc.getFilename();
+        cache.lineStarts = computeLineStarts(buffer);
+      }
+    }
+  }
+  lastFileID = FID;
+  lastFileCache = &cache;
+  return cache;
+}
+
+std::string
+FileTableInfo::normalizeFileName(StringRef filename) {
+  static char cwd[BUFSIZ];
+  static size_t cwdlen;
+
+  if (cwdlen == 0) {
+    getcwd(cwd, sizeof(cwd));
+    cwdlen = strlen(cwd);
+  }
+  SmallString<256> path(filename);
+  if (OptReproducible) {
+    sys::fs::make_absolute(path);
+    sys::path::remove_dots(path, true);
+  }
+  const StringRef name = path.str();
+  if (name.startswith(StringRef(cwd, cwdlen)) && name.size() > cwdlen
+      && name[cwdlen] == '/') {
+    return name.substr(cwdlen + 1).str();
+  }
+  return name.str();
+}
+
+int
+FileTableInfo::getFileId(const char *filename) {
+  const auto iter = idByPointer.find(filename);
+  if (iter != idByPointer.end()) {
+    return iter->second;
+  }
+  auto name = normalizeFileName(filename);
+  const auto result = idByName.emplace(name, fileNames.size());
+  if (result.second) {
+    fileNames.push_back(std::move(name));
+  }
+  const int id = result.first->second;
+  idByPointer[filename] = id;
+  return id;
+}
+
+///
+/// Local Variables:
+/// indent-tabs-mode: nil
+/// c-basic-offset: 2
+/// End:
+///
@@ -0,0 +1,106 @@
+#ifndef FILETABLEINFO_H
+#define FILETABLEINFO_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ * \brief Writes source locations to the XML elements and manages
+ * the file IDs of `<fileTable>`.
+ *
+ * The encoding is selected by `-location-encoding`:
+ * - `attributes`: `file`, `lineno` and `column` attributes (default)
+ * - `table`: `loc="fileId:line:col"`, where `fileId` refers to
+ *   `<file id="fileId" name="..."/>` in `<fileTable>`
+ * - `none`: no locations at all
+ */
+class FileTableInfo {
+public:
+  enum class Encoding {
+    Attributes,
+    Table,
+    None,
+  };
+
+  FileTableInfo() = delete;
+  FileTableInfo(const FileTableInfo &) = delete;
+  FileTableInfo(FileTableInfo &&) = delete;
+  FileTableInfo &operator=(const FileTableInfo &) = delete;
+  FileTableInfo &operator=(FileTableInfo &&) = delete;
+
+  explicit FileTableInfo(const clang::SourceManager &);
+
+  /*! \brief Returns the encoding selected by `-location-encoding`. */
+  static Encoding getSelectedEncoding();
+
+  /*! \brief The presumed location of a `SourceLocation`. */
+  struct ResolvedLoc {
+    const char *filename;
+    unsigned line;
+    unsigned column;
+  };
+
+  /*!
+   * \brief Computes the same location as
+   * `SourceManager::getPresumedLoc(Loc)`.
+   *
+   * Returns false if `Loc` has no presumed location.
+   */
+  bool resolve(clang::SourceLocation Loc, ResolvedLoc &result);
+
+  /*! \brief Adds the location attributes of `Loc` to `N`. */
+  void setLocation(xmlNodePtr N, clang::SourceLocation Loc);
+
+  /*!
+   * \brief Appends `<fileTable>` to `Parent` if the encoding is `table`.
+   */
+  void emitFileTable(xmlNodePtr Parent) const;
+
+  /*!
+   * \brief Returns `filename` as written to the output: relative to the
+   * current directory if it is under the directory.
+   *
+   * With `-reproducible`, `.` and `..` components are removed first,
+   * so that `./a.cpp` and `a.cpp` give the same name.
+   */
+  static std::string normalizeFileName(llvm::StringRef filename);
+
+private:
+  /*!
+   * \brief The line table of a file with no `#line` directives.
+   *
+   * Successive nodes are mostly in the same file and on nearby lines,
+   * so the search for a line starts at the line found last time.
+   */
+  struct FileCache {
+    /*! false if `SourceManager` must be asked (e.g. `#line`) */
+    bool isCached;
+    const char *filename;
+    /*! the offsets of the beginnings of lines */
+    std::vector<unsigned> lineStarts;
+    size_t lastLine;
+  };
+
+  FileCache &getFileCache(clang::FileID FID);
+
+  /*!
+   * \brief Returns the ID of `filename`, registering it if necessary.
+   *
+   * `PresumedLoc` returns the same pointer for every location in the
+   * same buffer, so the lookup by pointer usually succeeds.
+   */
+  int getFileId(const char *filename);
+
+  const clang::SourceManager &SM;
+  Encoding encoding;
+  clang::FileID lastFileID;
+  FileCache *lastFileCache;
+  std::unordered_map<unsigned, FileCache> fileCaches;
+  /*! the file names relative to the current directory, by ID */
+  std::vector<std::string> fileNames;
+  std::unordered_map<const char *, int> idByPointer;
+  std::unordered_map<std::string, int> idByName;
+};
+
+#endif /* !FILETABLEINFO_H */
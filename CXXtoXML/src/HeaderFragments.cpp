@@ -0,0 +1,320 @@
+#include <libxml/tree.h>
+#include <libxml/xmlsave.h>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+#include "HeaderFragments.h"
+#include "LibXMLUtil.h"
+
+namespace {
+
+/*! \brief The `file` of declarations that have no location. */
+const char builtinFileName[] = "<built-in>";
+
+/*! \brief The entries of `<xcodemlTypeTable>` or `<xcodemlNnsTable>`. */
+struct Table {
+  Table(xmlNodePtr node, const char *idName) : node(node) {
+    if (!node) {
+      return;
+    }
+    for (auto child = node->children; child; child = child->next) {
+      const auto id =
+          child->type == XML_ELEMENT_NODE ? findProp(child, idName) : nullptr;
+      if (id && index.emplace(id, entries.size()).second) {
+        entries.push_back(child);
+      }
+    }
+  }
+
+  xmlNodePtr node;
+  std::vector<xmlNodePtr> entries;
+  std::unordered_map<std::string, size_t> index;
+};
+
+/*!
+ * \brief Finds the table entries that a set of nodes refers to,
+ * directly or through other entries.
+ *
+ * Any attribute whose value is the name of an entry counts as a
+ * reference; type and NNS names are distinct from other attribute
+ * values.
+ */
+class ReferenceMarker {
+public:
+  ReferenceMarker(const Table &types, const Table &nnss)
+      : tables{&types, &nnss},
+        used{std::vector<bool>(types.entries.size()),
+            std::vector<bool>(nnss.entries.size())} {
+  }
+
+  void
+  markFrom(xmlNodePtr node) {
+    scan(node);
+    while (!pending.empty()) {
+      const auto entry = pending.back();
+      pending.pop_back();
+      scan(tables[entry.first]->entries[entry.second]);
+    }
+  }
+
+  bool
+  isUsed(int table, size_t i) const {
+    return used[table][i];
+  }
+
+private:
+  void
+  scan(xmlNodePtr node) {
+    for (auto attr = node->properties; attr; attr = attr->next) {
+      if (attr->children && attr->children->content) {
+        mark(reinterpret_cast<const char *>(attr->children->content));
+      }
+    }
+    for (auto child = node->children; child; child = child->next) {
+      if (child->type == XML_ELEMENT_NODE) {
+        scan(child);
+      }
+    }
+  }
+
+  void
+  mark(const std::string &value) {
+    for (int t = 0; t < 2; ++t) {
+      const auto iter = tables[t]->index.find(value);
+      if (iter != tables[t]->index.end() && !used[t][iter->second]) {
+        used[t][iter->second] = true;
+        pending.emplace_back(t, iter->second);
+      }
+    }
+  }
+
+  const Table *tables[2];
+  std::vector<bool> used[2];
+  std::vector<std::pair<int, size_t>> pending;
+};
+
+uint64_t
+hashFNV1a(const std::string &s, uint64_t h = 14695981039346656037ULL) {
+  for (const unsigned char c : s) {
+    h = (h ^ c) * 1099511628211ULL;
+  }
+  return h;
+}
+
+/*! \brief Returns the base name of `header` usable in a file name. */
+std::string
+makeFragmentBaseName(const std::string &header) {
+  const auto slash = header.rfind('/');
+  std::string name =
+      slash == std::string::npos ? header : header.substr(slash + 1);
+  for (auto &c : name) {
+    if (!isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '_'
+        && c != '-') {
+      c = '_';
+    }
+  }
+  return name;
+}
+
+std::string
+serialize(xmlDocPtr doc, int saveOptions) {
+  xmlBufferPtr buffer = xmlBufferCreate();
+  xmlSaveCtxtPtr ctxt = xmlSaveToBuffer(buffer, "UTF-8", saveOptions);
+  xmlSaveDoc(ctxt, doc);
+  xmlSaveClose(ctxt);
+  const std::string content(
+      reinterpret_cast<const char *>(xmlBufferContent(buffer)),
+      xmlBufferLength(buffer));
+  xmlBufferFree(buffer);
+  return content;
+}
+
+/*!
+ * \brief Writes `content` to `path` through a temporary file, so that
+ * a concurrent conversion never reads a partial fragment.
+ */
+bool
+writeFileAtomically(const std::string &path, const std::string &content) {
+  const auto tmp = path + "." + std::to_string(getpid()) + ".tmp";
+  FILE *out = std::fopen(tmp.c_str(), "wb");
+  if (!out) {
+    return false;
+  }
+  const bool ok =
+      std::fwrite(content.data(), 1, content.size(), out) == content.size();
+  if (std::fclose(out) != 0 || !ok
+      || std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+/*! \brief A run of consecutive top-level declarations from a header. */
+struct Run {
+  std::string header;
+  std::vector<xmlNodePtr> decls;
+};
+
+std::vector<Run>
+findHeaderRuns(xmlNodePtr translationUnit, const std::string &mainFile) {
+  std::vector<Run> runs;
+  bool isOpen = false;
+  for (auto child = translationUnit->children; child; child = child->next) {
+    if (!isElement(child, "clangDecl")) {
+      isOpen = false;
+      continue;
+    }
+    const auto file = findProp(child, "file");
+    const std::string header = file ? file : builtinFileName;
+    if (header == mainFile) {
+      isOpen = false;
+      continue;
+    }
+    if (!isOpen || runs.back().header != header) {
+      runs.push_back(Run{header, {}});
+      isOpen = true;
+    }
+    runs.back().decls.push_back(child);
+  }
+  return runs;
+}
+
+/*!
+ * \brief Appends the used entries of `table` to a new child `name` of
+ * `parent`.
+ */
+void
+copyUsedEntries(const Table &table,
+    int t,
+    const ReferenceMarker &marker,
+    const char *name,
+    xmlNodePtr parent,
+    std::vector<bool> &heldByFragment) {
+  const auto copy = xmlNewChild(parent, nullptr, BAD_CAST name, nullptr);
+  for (size_t i = 0; i < table.entries.size(); ++i) {
+    if (marker.isUsed(t, i)) {
+      xmlAddChild(copy, xmlDocCopyNode(table.entries[i], parent->doc, 1));
+      heldByFragment[i] = true;
+    }
+  }
+}
+
+} // namespace
+
+HeaderFragments::HeaderFragments(const std::string &dir, int saveOptions)
+    : dir(dir), saveOptions(saveOptions), files(), writtenCount(0) {
+}
+
+bool
+HeaderFragments::split(xmlNodePtr program, const std::string &mainFile) {
+  files.clear();
+  const auto ast = findChild(program, "clangAST");
+  const auto translationUnit =
+      ast ? findChild(ast, "clangDecl", "TranslationUnit") : nullptr;
+  if (!translationUnit) {
+    return true;
+  }
+  const Table types(
+      findChild(translationUnit, "xcodemlTypeTable"), "type");
+  const Table nnss(
+      findChild(translationUnit, "xcodemlNnsTable"), "nns");
+  std::vector<bool> typesInFragments(types.entries.size());
+  std::vector<bool> nnssInFragments(nnss.entries.size());
+
+  for (const auto &run : findHeaderRuns(translationUnit, mainFile)) {
+    ReferenceMarker marker(types, nnss);
+    for (const auto decl : run.decls) {
+      marker.markFrom(decl);
+    }
+    xmlDocPtr fragment = xmlNewDoc(BAD_CAST "1.0");
+    const auto root = xmlNewNode(nullptr, BAD_CAST "Program");
+    xmlDocSetRootElement(fragment, root);
+    xmlNewProp(root, BAD_CAST "source", BAD_CAST run.header.c_str());
+    xmlNewProp(root, BAD_CAST "language", BAD_CAST "C");
+    const auto fragmentAst =
+        xmlNewChild(root, nullptr, BAD_CAST "clangAST", nullptr);
+    // the attributes of the translation unit, without children
+    const auto fragmentUnit = xmlDocCopyNode(translationUnit, fragment, 2);
+    xmlAddChild(fragmentAst, fragmentUnit);
+    copyUsedEntries(types,
+        0,
+        marker,
+        "xcodemlTypeTable",
+        fragmentUnit,
+        typesInFragments);
+    copyUsedEntries(
+        nnss, 1, marker, "xcodemlNnsTable", fragmentUnit, nnssInFragments);
+
+    const auto ref = xmlNewNode(nullptr, BAD_CAST "fragmentRef");
+    xmlAddPrevSibling(run.decls.front(), ref);
+    for (const auto decl : run.decls) {
+      // copied, not moved: the documents may have different dictionaries
+      xmlAddChild(fragmentUnit, xmlDocCopyNode(decl, fragment, 1));
+      xmlUnlinkNode(decl);
+      xmlFreeNode(decl);
+    }
+
+    std::string hash, name;
+    const bool ok = writeFragment(run.header, fragment, hash, name);
+    xmlFreeDoc(fragment);
+    if (!ok) {
+      return false;
+    }
+    xmlNewProp(ref, BAD_CAST "header", BAD_CAST run.header.c_str());
+    xmlNewProp(ref, BAD_CAST "hash", BAD_CAST hash.c_str());
+    xmlNewProp(ref, BAD_CAST "name", BAD_CAST name.c_str());
+  }
+
+  // The resolver restores these entries from the fragments.
+  for (size_t i = 0; i < types.entries.size(); ++i) {
+    if (typesInFragments[i]) {
+      xmlUnlinkNode(types.entries[i]);
+      xmlFreeNode(types.entries[i]);
+    }
+  }
+  for (size_t i = 0; i < nnss.entries.size(); ++i) {
+    if (nnssInFragments[i]) {
+      xmlUnlinkNode(nnss.entries[i]);
+      xmlFreeNode(nnss.entries[i]);
+    }
+  }
+  return true;
+}
+
+bool
+HeaderFragments::writeFragment(const std::string &header,
+    xmlDocPtr fragment,
+    std::string &hash,
+    std::string &name) {
+  const auto content = serialize(fragment, saveOptions);
+  char hex[17];
+  snprintf(hex,
+      sizeof hex,
+      "%016llx",
+      static_cast<unsigned long long>(
+          hashFNV1a(content, hashFNV1a(header + '\0'))));
+  hash = hex;
+  name = makeFragmentBaseName(header) + "-" + hash;
+  const auto path = dir + "/" + name + ".xml";
+  files.push_back(path);
+  if (access(path.c_str(), F_OK) == 0) {
+    return true;
+  }
+  if (!writeFileAtomically(path, content)) {
+    return false;
+  }
+  ++writtenCount;
+  return true;
+}
+
+///
+/// Local Variables:
+/// indent-tabs-mode: nil
+/// c-basic-offset: 2
+/// End:
+///
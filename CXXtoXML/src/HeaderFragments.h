@@ -0,0 +1,77 @@
+#ifndef HEADERFRAGMENTS_H
+#define HEADERFRAGMENTS_H
+
+#include <string>
+#include <vector>
+
+/*!
+ * \brief Moves the declarations that come from headers into fragment
+ * files shared by translation units, enabled by `-header-fragments`.
+ *
+ * Each run of consecutive top-level declarations located in the same
+ * file other than the main file is moved into a fragment: a `<Program>`
+ * document of its own whose type table and NNS table hold the entries
+ * the declarations refer to (directly or through other entries). The
+ * run is replaced with `<fragmentRef header="..." hash="..."
+ * name="..."/>`, and the entries that some fragment holds are removed
+ * from the table of the translation unit.
+ *
+ * A fragment is keyed by the header path and the hash of its content,
+ * and is named `<header basename>-<hash>`. It is written to
+ * `<dir>/<name>.xml` unless the file exists, so translation units
+ * that see a header in the same way share one fragment. A header
+ * whose declarations differ (e.g. by macros defined before
+ * `#include`) yields another fragment.
+ *
+ * The declarations are told apart by their `file` attributes, so the
+ * locations must be written as attributes. The names of types and NNS
+ * must not depend on the translation unit, which `-reproducible`
+ * ensures.
+ */
+class HeaderFragments {
+public:
+  HeaderFragments() = delete;
+  HeaderFragments(const HeaderFragments &) = delete;
+  HeaderFragments(HeaderFragments &&) = delete;
+  HeaderFragments &operator=(const HeaderFragments &) = delete;
+  HeaderFragments &operator=(HeaderFragments &&) = delete;
+
+  /*!
+   * \param dir the directory to which fragments are written
+   * \param saveOptions the `xmlSaveOption` flags of the fragments
+   */
+  HeaderFragments(const std::string &dir, int saveOptions);
+
+  /*!
+   * \brief Moves the declarations of `program` (`<Program>`) not
+   * located in `mainFile` into fragments.
+   *
+   * Returns false if a fragment cannot be written.
+   */
+  bool split(xmlNodePtr program, const std::string &mainFile);
+
+  /*! \brief The paths of the fragments the last split() referred to. */
+  const std::vector<std::string> &
+  getFiles() const {
+    return files;
+  }
+
+  /*! \brief The number of fragments written (not found on disk). */
+  size_t
+  getWrittenCount() const {
+    return writtenCount;
+  }
+
+private:
+  bool writeFragment(const std::string &header,
+      xmlDocPtr fragment,
+      std::string &hash,
+      std::string &name);
+
+  std::string dir;
+  int saveOptions;
+  std::vector<std::string> files;
+  size_t writtenCount;
+};
+
+#endif /* !HEADERFRAGMENTS_H */
@@ -43,10 +43,11 @@ BaseClass::isVirtual() {
 
 std::vector<BaseClass>
 InheritanceInfo::getInheritance(clang::QualType type) {
-  return inheritance[type];
+  const auto bases = inheritance.find(type.getAsOpaquePtr());
+  return bases ? *bases : std::vector<BaseClass>();
 }
 
 void
 InheritanceInfo::addInheritance(clang::QualType derived, BaseClass base) {
-  inheritance[derived].push_back(base);
+  inheritance[derived.getAsOpaquePtr()].push_back(base);
 }
@@ -28,7 +28,7 @@ public:
 };
 
 class InheritanceInfo {
-  std::unordered_map<clang::QualType, std::vector<BaseClass>> inheritance;
+  OpaquePtrMap<std::vector<BaseClass>> inheritance;
 
 public:
   InheritanceInfo() = default;
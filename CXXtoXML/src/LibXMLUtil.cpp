@@ -0,0 +1,35 @@
+#include <cstring>
+#include "LibXMLUtil.h"
+
+bool
+isElement(xmlNodePtr node, const char *name, const char *className) {
+  if (!node || node->type != XML_ELEMENT_NODE
+      || !xmlStrEqual(node->name, BAD_CAST name)) {
+    return false;
+  }
+  if (!className) {
+    return true;
+  }
+  const auto value = findProp(node, "class");
+  return value && std::strcmp(value, className) == 0;
+}
+
+const char *
+findProp(xmlNodePtr node, const char *name) {
+  const auto attr = xmlHasProp(node, BAD_CAST name);
+  if (!attr || !attr->children || !attr->children->content) {
+    return nullptr;
+  }
+  return reinterpret_cast<const char *>(attr->children->content);
+}
+
+xmlNodePtr
+findChild(xmlNodePtr node, const char *name, const char *className) {
+  for (auto child = node ? node->children : nullptr; child;
+       child = child->next) {
+    if (isElement(child, name, className)) {
+      return child;
+    }
+  }
+  return nullptr;
+}
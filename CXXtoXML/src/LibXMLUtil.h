@@ -0,0 +1,31 @@
+#ifndef LIBXMLUTIL_H
+#define LIBXMLUTIL_H
+
+#include <libxml/tree.h>
+
+/*!
+ * \brief Returns true if `node` is a `name` element and, if `className`
+ * is given, its class attribute is `className`.
+ *
+ * `node` may be nullptr.
+ */
+bool isElement(
+    xmlNodePtr node, const char *name, const char *className = nullptr);
+
+/*!
+ * \brief Returns the value of the attribute `name` of `node`, or nullptr.
+ *
+ * The value is owned by the document, so it is not copied or freed.
+ */
+const char *findProp(xmlNodePtr node, const char *name);
+
+/*!
+ * \brief Returns the first child of `node` that `isElement(child, name,
+ * className)` accepts, or nullptr.
+ *
+ * `node` may be nullptr.
+ */
+xmlNodePtr findChild(
+    xmlNodePtr node, const char *name, const char *className = nullptr);
+
+#endif /* !LIBXMLUTIL_H */
@@ -5,6 +5,7 @@
 #include <libxml/tree.h>
 #include "clang/AST/Mangle.h"
 #include "clang/AST/ASTContext.h"
+#include "XMLVisitorBase.h"
 #include "TypeTableInfo.h"
 
 #include "NnsTableInfo.h"
@@ -13,8 +14,8 @@ NnsTableInfo::NnsTableInfo(clang::MangleContext *MC, TypeTableInfo *TTI)
     : seqForOther(0),
       mangleContext(MC),
       typetableinfo(TTI),
-      mapForOtherNns(),
-      mapFromNestedNameSpecToXmlNodePtr() {
+      mapFromNestedNameSpecToRecord(),
+      nnsRecords() {
   assert(typetableinfo);
 }
 
@@ -25,10 +26,12 @@ NnsTableInfo::getNnsName(const clang::NestedNameSpecifier *NestedNameSpec) {
     return "global";
   }
 
-  if (mapForOtherNns.count(NestedNameSpec) == 0) {
+  auto index = mapFromNestedNameSpecToRecord.find(NestedNameSpec);
+  if (!index) {
     registerNestedNameSpec(NestedNameSpec);
+    index = mapFromNestedNameSpecToRecord.find(NestedNameSpec);
   }
-  return mapForOtherNns[NestedNameSpec];
+  return nnsRecords[*index].name;
 }
 
 void
@@ -71,6 +74,17 @@ makeNnsIdentNodeForType(NnsTableInfo &NTI,
   return node;
 }
 
+std::string
+getSpelling(
+    const clang::NestedNameSpecifier &Spec, const clang::MangleContext &MC) {
+  clang::PrintingPolicy policy(MC.getASTContext().getLangOpts());
+  policy.AnonymousTagLocations = false;
+  std::string ostr;
+  llvm::raw_string_ostream os(ostr);
+  Spec.print(os, policy);
+  return os.str();
+}
+
 // clang::NestedNameSpecifier::dump is not a const member fucntion.
 void
 dump(const clang::NestedNameSpecifier &Spec, const clang::MangleContext &MC) {
@@ -122,17 +136,31 @@ NnsTableInfo::registerNestedNameSpec(
   }
 
   const auto prefix = static_cast<std::string>("NNS");
-  const auto name = prefix + std::to_string(seqForOther++);
-  mapForOtherNns[NestedNameSpec] = name;
-  mapFromNestedNameSpecToXmlNodePtr[NestedNameSpec] =
-      makeNnsIdentNodeForNestedNameSpec(
-          *mangleContext, *this, *typetableinfo, NestedNameSpec);
+  std::string name;
+  if (typetableinfo->isUsingPlaceholderNames()) {
+    name = typetableinfo->makePlaceholderName(NestedNameSpec, true);
+  } else if (OptReproducible) {
+    auto spelling = getSpelling(*NestedNameSpec, *mangleContext);
+    if (const auto T = NestedNameSpec->getAsType()) {
+      typetableinfo->appendTagLocations(clang::QualType(T, 0), spelling);
+    }
+    name = typetableinfo->makeStableName(prefix, spelling);
+  } else {
+    name = prefix + std::to_string(seqForOther++);
+  }
+  const unsigned index = nnsRecords.size();
+  nnsRecords.push_back(NnsRecord{name, nullptr});
+  mapFromNestedNameSpecToRecord.insert(NestedNameSpec, index);
+  // The node refers to the name registered above.
+  const auto node = makeNnsIdentNodeForNestedNameSpec(
+      *mangleContext, *this, *typetableinfo, NestedNameSpec);
+  nnsRecords[index].node = node;
   pushNns(NestedNameSpec);
 }
 
 xmlNodePtr
 NnsTableInfo::getNnsNode(const clang::NestedNameSpecifier *Spec) const {
-  auto iter = mapFromNestedNameSpecToXmlNodePtr.find(Spec);
-  assert(iter != mapFromNestedNameSpecToXmlNodePtr.end());
-  return iter->second;
+  const auto index = mapFromNestedNameSpecToRecord.find(Spec);
+  assert(index);
+  return nnsRecords[*index].node;
 }
@@ -1,6 +1,8 @@
 #ifndef NNSTABLEINFO_H
 #define NNSTABLEINFO_H
 
+#include "OpaquePtrMap.h"
+
 class TypeTableInfo;
 
 class NnsTableInfo {
@@ -22,12 +24,17 @@ private:
   void registerNestedNameSpec(const clang::NestedNameSpecifier *);
 
 private:
+  struct NnsRecord {
+    std::string name;
+    xmlNodePtr node;
+  };
+
   int seqForOther;
   clang::MangleContext *mangleContext;
   TypeTableInfo *typetableinfo;
-  std::map<const clang::NestedNameSpecifier *, std::string> mapForOtherNns;
-  std::map<const clang::NestedNameSpecifier *, xmlNodePtr>
-      mapFromNestedNameSpecToXmlNodePtr;
+  // index into nnsRecords
+  OpaquePtrMap<unsigned> mapFromNestedNameSpecToRecord;
+  std::vector<NnsRecord> nnsRecords;
   std::stack<std::tuple<xmlNodePtr,
       std::vector<const clang::NestedNameSpecifier *>>> nnsTableStack;
 };
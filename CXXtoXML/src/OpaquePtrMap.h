@@ -0,0 +1,172 @@
+#ifndef OPAQUEPTRMAP_H
+#define OPAQUEPTRMAP_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*!
+ * \brief Hashes a pointer-sized key (the finalizer of MurmurHash3).
+ *
+ * AST nodes are allocated with 8- or 16-byte alignment, and
+ * clang::QualType keeps its qualifiers in the low bits of the opaque
+ * pointer, so the raw value is a poor bucket index.
+ */
+inline std::size_t
+hashOpaquePtr(const void *p) {
+  auto h = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(p));
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return static_cast<std::size_t>(h);
+}
+
+/*!
+ * \brief Open-addressing hash table keyed by non-null pointers
+ * such as `clang::QualType::getAsOpaquePtr()`.
+ *
+ * Linear probing over a power-of-two array of (key, value) slots.
+ * erase() moves the following entries of the cluster back,
+ * so the table never holds tombstones.
+ * A pointer returned by find() or insert() is invalidated
+ * by the next insertion or erasure.
+ */
+template <typename V> class OpaquePtrMap {
+  struct Slot {
+    const void *key; // nullptr: empty
+    V value;
+  };
+  std::vector<Slot> slots;
+  std::size_t count;
+
+  std::size_t
+  indexFor(const void *key) const {
+    const std::size_t mask = slots.size() - 1;
+    std::size_t i = hashOpaquePtr(key) & mask;
+    while (slots[i].key && slots[i].key != key) {
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+
+  void
+  grow() {
+    std::vector<Slot> old(slots.empty() ? 16 : slots.size() * 2);
+    old.swap(slots);
+    for (auto &slot : old) {
+      if (slot.key) {
+        auto &dst = slots[indexFor(slot.key)];
+        dst.key = slot.key;
+        dst.value = std::move(slot.value);
+      }
+    }
+  }
+
+public:
+  OpaquePtrMap() : slots(), count(0) {
+  }
+
+  std::size_t
+  size() const {
+    return count;
+  }
+
+  bool
+  empty() const {
+    return count == 0;
+  }
+
+  V *
+  find(const void *key) {
+    assert(key);
+    if (slots.empty()) {
+      return nullptr;
+    }
+    auto &slot = slots[indexFor(key)];
+    return slot.key ? &slot.value : nullptr;
+  }
+
+  const V *
+  find(const void *key) const {
+    return const_cast<OpaquePtrMap *>(this)->find(key);
+  }
+
+  /*!
+   * \brief Inserts `value` unless `key` is already present.
+   * \return The value stored for `key` and whether it was inserted.
+   */
+  std::pair<V *, bool>
+  insert(const void *key, V value) {
+    assert(key);
+    // keep the load factor at most 3/4
+    if ((count + 1) * 4 > slots.size() * 3) {
+      grow();
+    }
+    auto &slot = slots[indexFor(key)];
+    if (slot.key) {
+      return std::make_pair(&slot.value, false);
+    }
+    slot.key = key;
+    slot.value = std::move(value);
+    ++count;
+    return std::make_pair(&slot.value, true);
+  }
+
+  V &operator[](const void *key) {
+    return *insert(key, V()).first;
+  }
+
+  bool
+  erase(const void *key) {
+    assert(key);
+    if (slots.empty()) {
+      return false;
+    }
+    const std::size_t mask = slots.size() - 1;
+    std::size_t hole = indexFor(key);
+    if (!slots[hole].key) {
+      return false;
+    }
+    for (std::size_t i = (hole + 1) & mask; slots[i].key;
+         i = (i + 1) & mask) {
+      const std::size_t home = hashOpaquePtr(slots[i].key) & mask;
+      // slots[i] stays if its home lies cyclically in (hole, i]
+      const bool stays = hole <= i ? (hole < home && home <= i)
+                                   : (hole < home || home <= i);
+      if (!stays) {
+        slots[hole].key = slots[i].key;
+        slots[hole].value = std::move(slots[i].value);
+        hole = i;
+      }
+    }
+    slots[hole].key = nullptr;
+    slots[hole].value = V();
+    --count;
+    return true;
+  }
+
+  void
+  clear() {
+    slots.clear();
+    count = 0;
+  }
+
+  /*!
+   * \brief Calls `f(key, value)` for each entry in unspecified order.
+   */
+  template <typename F>
+  void
+  forEach(F f) const {
+    for (auto &slot : slots) {
+      if (slot.key) {
+        f(slot.key, slot.value);
+      }
+    }
+  }
+};
+
+#endif /* !OPAQUEPTRMAP_H */
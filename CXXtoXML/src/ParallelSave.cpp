@@ -0,0 +1,163 @@
+#include <libxml/tree.h>
+#include <libxml/xmlsave.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <limits.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "LibXMLUtil.h"
+#include "ParallelSave.h"
+
+namespace {
+
+/*! \brief Stands for the children of the translation unit. */
+const char placeholder[] = "\1save-jobs\1";
+
+/*! \brief Whether libxml2 stops indenting the children of `node`. */
+bool
+hasText(xmlNodePtr node) {
+  for (auto child = node->children; child; child = child->next) {
+    if (child->type == XML_TEXT_NODE || child->type == XML_CDATA_SECTION_NODE
+        || child->type == XML_ENTITY_REF_NODE) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*! \brief Returns the level at which libxml2 dumps `node`. */
+int
+getLevel(xmlNodePtr node) {
+  int level = 0;
+  for (auto parent = node->parent; parent && parent->type == XML_ELEMENT_NODE;
+       parent = parent->parent) {
+    ++level;
+  }
+  return level;
+}
+
+std::string
+saveWhole(xmlDocPtr doc, int options) {
+  xmlBufferPtr buffer = xmlBufferCreate();
+  xmlSaveCtxtPtr ctxt = xmlSaveToBuffer(buffer, "UTF-8", options);
+  xmlSaveDoc(ctxt, doc);
+  xmlSaveClose(ctxt);
+  const std::string content(
+      reinterpret_cast<const char *>(xmlBufferContent(buffer)),
+      xmlBufferLength(buffer));
+  xmlBufferFree(buffer);
+  return content;
+}
+
+} // namespace
+
+std::vector<std::string>
+saveDocument(xmlDocPtr doc, int options, unsigned jobs) {
+  const auto root = xmlDocGetRootElement(doc);
+  const auto ast = root ? findChild(root, "clangAST") : nullptr;
+  const auto unit = ast ? findChild(ast, "clangDecl") : nullptr;
+  if (jobs <= 1 || !unit || !unit->children || hasText(unit)) {
+    return {saveWhole(doc, options)};
+  }
+  std::vector<xmlNodePtr> nodes;
+  for (auto child = unit->children; child; child = child->next) {
+    nodes.push_back(child);
+  }
+
+  // Save the document with the placeholder as the only child of the
+  // translation unit; the children keep their links and are restored
+  // as they were.
+  const auto marker = xmlNewDocComment(doc, BAD_CAST placeholder);
+  marker->parent = unit;
+  unit->children = unit->last = marker;
+  const auto skeleton = saveWhole(doc, options);
+  unit->children = nodes.front();
+  unit->last = nodes.back();
+  xmlFreeNode(marker);
+
+  const auto comment = std::string("<!--") + placeholder + "-->";
+  const auto pos = skeleton.find(comment);
+  if (pos == std::string::npos || pos == 0) {
+    return {saveWhole(doc, options)};
+  }
+  // When libxml2 indents the children, it writes each on its own line
+  // after the indentation of the placeholder.
+  auto begin = pos;
+  auto end = pos + comment.size();
+  const bool format = end < skeleton.size() && skeleton[end] == '\n';
+  std::string indent;
+  if (format) {
+    begin = skeleton.rfind('\n', pos - 1) + 1;
+    indent = skeleton.substr(begin, pos - begin);
+    ++end;
+  }
+  std::vector<std::string> chunks(nodes.size() + 2);
+  chunks.front() = skeleton.substr(0, begin);
+  chunks.back() = skeleton.substr(end);
+
+  const int level = getLevel(nodes.front());
+  std::atomic<size_t> next(0);
+  const auto dump = [&]() {
+    xmlBufferPtr buffer = xmlBufferCreate();
+    for (size_t i = next++; i < nodes.size(); i = next++) {
+      xmlOutputBufferPtr out = xmlOutputBufferCreateBuffer(buffer, nullptr);
+      xmlNodeDumpOutput(out, doc, nodes[i], level, format, "UTF-8");
+      xmlOutputBufferClose(out);
+      auto &chunk = chunks[i + 1];
+      chunk.reserve(indent.size() + xmlBufferLength(buffer) + 1);
+      chunk = indent;
+      chunk.append(reinterpret_cast<const char *>(xmlBufferContent(buffer)),
+          xmlBufferLength(buffer));
+      if (format) {
+        chunk += '\n';
+      }
+      xmlBufferEmpty(buffer);
+    }
+    xmlBufferFree(buffer);
+  };
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < jobs && i < nodes.size(); ++i) {
+    threads.emplace_back(dump);
+  }
+  dump();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return chunks;
+}
+
+bool
+writeChunks(int fd, const std::vector<std::string> &chunks) {
+  std::vector<iovec> iov;
+  for (const auto &chunk : chunks) {
+    if (!chunk.empty()) {
+      iov.push_back({const_cast<char *>(chunk.data()), chunk.size()});
+    }
+  }
+  size_t i = 0;
+  while (i < iov.size()) {
+    const auto count = std::min<size_t>(iov.size() - i, IOV_MAX);
+    const ssize_t written = writev(fd, &iov[i], count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    // skip what is written, which may end in the middle of a chunk
+    size_t rest = written;
+    while (i < iov.size() && rest >= iov[i].iov_len) {
+      rest -= iov[i].iov_len;
+      ++i;
+    }
+    if (rest > 0) {
+      iov[i].iov_base = static_cast<char *>(iov[i].iov_base) + rest;
+      iov[i].iov_len -= rest;
+    }
+  }
+  return true;
+}
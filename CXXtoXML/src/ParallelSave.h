@@ -0,0 +1,33 @@
+#ifndef PARALLELSAVE_H
+#define PARALLELSAVE_H
+
+#include <string>
+#include <vector>
+
+/*!
+ * \brief Serializes `doc` as `xmlSaveDoc` does with the encoding UTF-8
+ * and `options`, and returns the bytes in pieces (`-save-jobs`).
+ *
+ * The children of the translation unit (`<clangDecl>` under
+ * `<clangAST>`) hold nearly all of the document; each of them is
+ * dumped with `xmlNodeDumpOutput` at its depth, in `jobs` threads.
+ * The rest of the document is saved once with a placeholder comment
+ * in place of those children, which yields the text around them and
+ * their indentation, so the concatenation of the pieces is exactly
+ * what `xmlSaveDoc` writes.
+ *
+ * The document is saved in one piece if `jobs` is at most 1, or if the
+ * translation unit has no children or has text among them (which
+ * would change how libxml2 indents them).
+ */
+std::vector<std::string> saveDocument(
+    xmlDocPtr doc, int options, unsigned jobs);
+
+/*!
+ * \brief Writes the concatenation of `chunks` to `fd` with `writev`.
+ *
+ * Returns false on an error.
+ */
+bool writeChunks(int fd, const std::vector<std::string> &chunks);
+
+#endif /* !PARALLELSAVE_H */
@@ -0,0 +1,367 @@
+#include <libxml/tree.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ParallelTraversal.h"
+
+namespace {
+
+/*! \brief The first character of a placeholder. */
+const char placeholderMark = '\1';
+
+void
+appendWord(std::string &out, uint64_t value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof value);
+}
+
+bool
+readWord(const std::string &data, size_t &pos, uint64_t &value) {
+  if (data.size() - pos < sizeof value) {
+    return false;
+  }
+  std::memcpy(&value, data.data() + pos, sizeof value);
+  pos += sizeof value;
+  return true;
+}
+
+void
+appendString(std::string &out, const xmlChar *s) {
+  if (s) {
+    out += reinterpret_cast<const char *>(s);
+  }
+  out += '\0';
+}
+
+/*!
+ * \brief Reads the tree format of appendTree.
+ *
+ * - element: `E` name `\0`, `A` name `\0` value `\0` for each
+ *   attribute, the children, and `)`
+ * - text: `T` content `\0`
+ * - comment: `C` content `\0`
+ */
+class TreeReader {
+public:
+  TreeReader(const std::string &data, const std::vector<std::string> &names)
+      : p(data.data()), end(data.data() + data.size()), names(names) {
+  }
+
+  bool
+  readAll(xmlNodePtr parent) {
+    while (p != end) {
+      if (!readNode(parent)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  bool
+  readString(const char *&s) {
+    const auto nul = static_cast<const char *>(std::memchr(p, '\0', end - p));
+    if (!nul) {
+      return false;
+    }
+    s = p;
+    p = nul + 1;
+    return true;
+  }
+
+  const char *
+  rename(const char *value) {
+    if (value[0] != placeholderMark) {
+      return value;
+    }
+    char *last;
+    const auto index = std::strtoul(value + 1, &last, 10);
+    return *last == '\0' && index < names.size() ? names[index].c_str()
+                                                 : nullptr;
+  }
+
+  bool
+  readNode(xmlNodePtr parent) {
+    const char kind = *p++;
+    const char *s;
+    if (!readString(s)) {
+      return false;
+    }
+    switch (kind) {
+    case 'T':
+      xmlAddChild(parent, xmlNewDocText(parent->doc, BAD_CAST s));
+      return true;
+    case 'C':
+      xmlAddChild(parent, xmlNewDocComment(parent->doc, BAD_CAST s));
+      return true;
+    case 'E': break;
+    default: return false;
+    }
+    const auto node = xmlNewDocNode(parent->doc, nullptr, BAD_CAST s, nullptr);
+    xmlAddChild(parent, node);
+    while (p != end && *p == 'A') {
+      ++p;
+      const char *name, *value;
+      if (!readString(name) || !readString(value)) {
+        return false;
+      }
+      value = rename(value);
+      if (!value) {
+        return false;
+      }
+      xmlNewProp(node, BAD_CAST name, BAD_CAST value);
+    }
+    while (p != end && *p != ')') {
+      if (!readNode(node)) {
+        return false;
+      }
+    }
+    if (p == end) {
+      return false;
+    }
+    ++p;
+    return true;
+  }
+
+  const char *p;
+  const char *end;
+  const std::vector<std::string> &names;
+};
+
+bool
+readFile(FILE *file, std::string &content) {
+  if (std::fseek(file, 0, SEEK_END) != 0) {
+    return false;
+  }
+  const long size = std::ftell(file);
+  if (size < 0 || std::fseek(file, 0, SEEK_SET) != 0) {
+    return false;
+  }
+  content.resize(size);
+  return std::fread(&content[0], 1, size, file) == content.size();
+}
+
+} // namespace
+
+std::string
+encodeTraversalResult(const TraversalResult &result) {
+  std::string data;
+  appendWord(data, result.names.size());
+  for (const auto &name : result.names) {
+    appendWord(data, reinterpret_cast<uintptr_t>(name.first));
+    appendWord(data, name.second);
+  }
+  appendWord(data, result.filterCounts.size());
+  for (const auto count : result.filterCounts) {
+    appendWord(data, count);
+  }
+  appendWord(data, result.nodeCounts.size());
+  for (const auto &count : result.nodeCounts) {
+    appendWord(data, count.first.size());
+    data += count.first;
+    appendWord(data, count.second);
+  }
+  data += result.trees;
+  return data;
+}
+
+bool
+decodeTraversalResult(const std::string &data, TraversalResult &result) {
+  size_t pos = 0;
+  uint64_t size;
+  if (!readWord(data, pos, size)) {
+    return false;
+  }
+  result.names.clear();
+  for (uint64_t i = 0; i < size; ++i) {
+    uint64_t key, isNns;
+    if (!readWord(data, pos, key) || !readWord(data, pos, isNns)) {
+      return false;
+    }
+    result.names.emplace_back(
+        reinterpret_cast<const void *>(static_cast<uintptr_t>(key)),
+        isNns != 0);
+  }
+  if (!readWord(data, pos, size)) {
+    return false;
+  }
+  result.filterCounts.clear();
+  for (uint64_t i = 0; i < size; ++i) {
+    uint64_t count;
+    if (!readWord(data, pos, count)) {
+      return false;
+    }
+    result.filterCounts.push_back(count);
+  }
+  if (!readWord(data, pos, size)) {
+    return false;
+  }
+  result.nodeCounts.clear();
+  for (uint64_t i = 0; i < size; ++i) {
+    uint64_t length, count;
+    if (!readWord(data, pos, length) || data.size() - pos < length) {
+      return false;
+    }
+    const auto key = data.substr(pos, length);
+    pos += length;
+    if (!readWord(data, pos, count)) {
+      return false;
+    }
+    result.nodeCounts.emplace_back(key, count);
+  }
+  result.trees = data.substr(pos);
+  return true;
+}
+
+std::string
+encodeTraversalResults(const std::vector<TraversalResult> &results) {
+  std::string data;
+  for (const auto &result : results) {
+    const auto encoded = encodeTraversalResult(result);
+    appendWord(data, encoded.size());
+    data += encoded;
+  }
+  return data;
+}
+
+bool
+decodeTraversalResults(
+    const std::string &data, std::vector<TraversalResult> &results) {
+  results.clear();
+  for (size_t pos = 0; pos < data.size();) {
+    uint64_t size;
+    if (!readWord(data, pos, size) || data.size() - pos < size) {
+      return false;
+    }
+    results.emplace_back();
+    if (!decodeTraversalResult(data.substr(pos, size), results.back())) {
+      return false;
+    }
+    pos += size;
+  }
+  return true;
+}
+
+std::string
+makePlaceholderName(size_t index) {
+  return placeholderMark + std::to_string(index);
+}
+
+void
+appendTree(xmlNodePtr node, std::string &out) {
+  switch (node->type) {
+  case XML_TEXT_NODE:
+    out += 'T';
+    appendString(out, node->content);
+    return;
+  case XML_COMMENT_NODE:
+    out += 'C';
+    appendString(out, node->content);
+    return;
+  case XML_ELEMENT_NODE: break;
+  default: return;
+  }
+  out += 'E';
+  appendString(out, node->name);
+  for (auto attr = node->properties; attr; attr = attr->next) {
+    out += 'A';
+    appendString(out, attr->name);
+    // xmlNewProp makes a single text node
+    for (auto text = attr->children; text; text = text->next) {
+      if (text->content) {
+        out += reinterpret_cast<const char *>(text->content);
+      }
+    }
+    out += '\0';
+  }
+  for (auto child = node->children; child; child = child->next) {
+    appendTree(child, out);
+  }
+  out += ')';
+}
+
+bool
+appendTrees(xmlNodePtr parent,
+    const std::string &data,
+    const std::vector<std::string> &names) {
+  TreeReader reader(data, names);
+  return reader.readAll(parent);
+}
+
+std::vector<size_t>
+partitionByWeight(const std::vector<size_t> &weights, unsigned parts) {
+  size_t total = 0;
+  for (const auto weight : weights) {
+    total += weight;
+  }
+  std::vector<size_t> begins{0};
+  size_t sum = 0;
+  for (size_t i = 0; i + 1 < weights.size(); ++i) {
+    sum += weights[i];
+    if (begins.size() < parts && sum * parts >= total * begins.size()) {
+      begins.push_back(i + 1);
+    }
+  }
+  begins.push_back(weights.size());
+  return begins;
+}
+
+bool
+startWorker(const std::function<std::string()> &work, Worker &worker) {
+  worker.file = std::tmpfile();
+  if (!worker.file) {
+    return false;
+  }
+  worker.pid = fork();
+  if (worker.pid == 0) {
+    const auto result = work();
+    const bool written =
+        std::fwrite(result.data(), 1, result.size(), worker.file)
+            == result.size()
+        && std::fflush(worker.file) == 0;
+    _exit(written ? 0 : 1);
+  }
+  if (worker.pid < 0) {
+    std::fclose(worker.file);
+    return false;
+  }
+  return true;
+}
+
+bool
+finishWorker(Worker &worker, std::string &result) {
+  int status;
+  const bool ok = waitpid(worker.pid, &status, 0) == worker.pid
+      && WIFEXITED(status) && WEXITSTATUS(status) == 0
+      && readFile(worker.file, result);
+  std::fclose(worker.file);
+  return ok;
+}
+
+bool
+runWorkers(unsigned count,
+    const std::function<std::string(unsigned)> &work,
+    std::vector<std::string> &results) {
+  std::vector<Worker> workers;
+  bool ok = true;
+  for (unsigned i = 0; i < count; ++i) {
+    Worker worker;
+    if (!startWorker([&]() { return work(i); }, worker)) {
+      ok = false;
+      break;
+    }
+    workers.push_back(worker);
+  }
+  results.assign(workers.size(), std::string());
+  for (size_t i = 0; i < workers.size(); ++i) {
+    ok = finishWorker(workers[i], results[i]) && ok;
+  }
+  return ok;
+}
@@ -0,0 +1,126 @@
+#ifndef PARALLELTRAVERSAL_H
+#define PARALLELTRAVERSAL_H
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+#include "ConversionStats.h"
+
+/*!
+ * \file
+ * \brief The parts of `-traversal-jobs` and `-pipeline-jobs` that do
+ * not depend on clang.
+ *
+ * After parsing, the top-level declarations of the translation unit
+ * are split into contiguous ranges, and each range is converted by a
+ * worker process forked from CXXtoXML. A worker has its own copy of
+ * the AST, of clang's caches and of the visitor, so nothing is shared
+ * between workers; the AST is still in the memory of the parent, so a
+ * type or an NNS is identified by the same pointer in every process.
+ *
+ * A worker names the types and NNS it registers with placeholders
+ * (makePlaceholderName) and records what each placeholder stands for.
+ * The parent registers them again in the order of the workers, which
+ * is the order a sequential run registers them in, so it assigns the
+ * same names and builds the same tables; then it appends the elements
+ * of the workers with the placeholders replaced by these names.
+ */
+
+/*! \brief What a worker sends back to the parent. */
+struct TraversalResult {
+  /*!
+   * The type (false) or NNS (true) that each placeholder stands for,
+   * by index.
+   */
+  std::vector<std::pair<const void *, bool>> names;
+  /*! The counts of `DeclFilter::getCounts`. */
+  std::vector<size_t> filterCounts;
+  /*! The nodes counted for `-stats`. */
+  NodeCounts nodeCounts;
+  /*! The top-level elements in the format of `appendTree`. */
+  std::string trees;
+};
+
+std::string encodeTraversalResult(const TraversalResult &result);
+
+/*! \brief Returns false if `data` is not a complete result. */
+bool decodeTraversalResult(const std::string &data, TraversalResult &result);
+
+/*! \brief Encodes a sequence of results into one string. */
+std::string encodeTraversalResults(const std::vector<TraversalResult> &);
+
+bool decodeTraversalResults(
+    const std::string &data, std::vector<TraversalResult> &results);
+
+/*!
+ * \brief Returns the placeholder for the `index`th name registered by
+ * a worker.
+ *
+ * It begins with a control character, which no other attribute value
+ * written by CXXtoXML does.
+ */
+std::string makePlaceholderName(size_t index);
+
+/*!
+ * \brief Appends `node` and its descendants to `out`, exactly (e.g.
+ * empty text nodes are kept, unlike with XML).
+ */
+void appendTree(xmlNodePtr node, std::string &out);
+
+/*!
+ * \brief Appends the trees of `data` to the children of `parent`,
+ * replacing the attribute values that are placeholders with `names`.
+ *
+ * Returns false if `data` is malformed.
+ */
+bool appendTrees(xmlNodePtr parent,
+    const std::string &data,
+    const std::vector<std::string> &names);
+
+/*!
+ * \brief Splits items of `weights` into at most `parts` contiguous
+ * ranges of about the same total weight.
+ *
+ * Returns the index at which each range begins, followed by
+ * `weights.size()`.
+ */
+std::vector<size_t> partitionByWeight(
+    const std::vector<size_t> &weights, unsigned parts);
+
+/*! \brief A forked process running a function. */
+struct Worker {
+  pid_t pid;
+  /*! where the worker writes what the function returns */
+  FILE *file;
+};
+
+/*!
+ * \brief Runs `work()` in a forked process, which leaves with `_exit`.
+ *
+ * Returns false if the process cannot be started.
+ */
+bool startWorker(const std::function<std::string()> &work, Worker &worker);
+
+/*!
+ * \brief Waits for `worker` and stores what it returned in `result`.
+ *
+ * Returns false if it does not finish successfully.
+ */
+bool finishWorker(Worker &worker, std::string &result);
+
+/*!
+ * \brief Runs `work(0)`, ..., `work(count - 1)` in forked processes
+ * and stores what they return in `results`.
+ *
+ * A worker leaves with `_exit`, so it never flushes the output buffers
+ * or runs the destructors of the parent. Returns false if a worker
+ * cannot be started or does not finish successfully.
+ */
+bool runWorkers(unsigned count,
+    const std::function<std::string(unsigned)> &work,
+    std::vector<std::string> &results);
+
+#endif /* !PARALLELTRAVERSAL_H */
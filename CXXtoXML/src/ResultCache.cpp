@@ -0,0 +1,466 @@
+#include "XMLRAV.h"
+#include "clang/Basic/Version.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "ResultCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <zlib.h>
+
+using namespace llvm;
+
+static cl::opt<std::string> OptCacheDir("cache-dir",
+    cl::desc("reuse the output for unchanged sources, kept in this "
+             "directory"),
+    cl::value_desc("directory"),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<unsigned> OptCacheMaxSize("cache-max-size",
+    cl::desc("the size limit of -cache-dir in megabytes (default: 1024)"),
+    cl::init(1024),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<bool> OptCacheStats("cache-stats",
+    cl::desc("print the hits and misses of -cache-dir to stderr"),
+    cl::cat(CXX2XMLCategory));
+
+// Change this when the format of the cache changes.
+static const char cacheFormat[] = "CXXtoXML cache 1";
+
+// The number of entries a manifest keeps (newest first).
+static const size_t maxManifestEntries = 16;
+
+static const char *const counterNames[] = {
+    "hits",
+    "misses",
+    "stores",
+    "evictions",
+};
+
+namespace {
+
+class Hasher {
+  MD5 md5;
+
+public:
+  /*! \brief Adds `s` followed by a separator. */
+  void
+  add(StringRef s) {
+    md5.update(s);
+    md5.update(StringRef("", 1));
+  }
+
+  std::string
+  final() {
+    MD5::MD5Result result;
+    md5.final(result);
+    SmallString<32> hex;
+    MD5::stringifyResult(result, hex);
+    return std::string(hex.begin(), hex.end());
+  }
+};
+
+bool
+readFile(const std::string &path, std::string &content) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  content = ss.str();
+  return true;
+}
+
+bool
+readCompressedFile(const std::string &path, std::string &content) {
+  const gzFile in = gzopen(path.c_str(), "rb");
+  if (!in) {
+    return false;
+  }
+  content.clear();
+  char buffer[65536];
+  int n;
+  while ((n = gzread(in, buffer, sizeof buffer)) > 0) {
+    content.append(buffer, n);
+  }
+  return gzclose(in) == Z_OK && n == 0;
+}
+
+/*!
+ * \brief Writes `content` to `path` through a temporary file, so that
+ * concurrent readers never see a partial file.
+ */
+bool
+writeFileAtomically(
+    const std::string &path, const std::string &content, bool compress) {
+  const auto tmp = path + "." + std::to_string(getpid()) + ".tmp";
+  bool ok;
+  if (compress) {
+    const gzFile out = gzopen(tmp.c_str(), "wb");
+    ok = out
+        && (content.empty()
+               || gzwrite(out, content.data(), content.size()) > 0);
+    ok = out && gzclose(out) == Z_OK && ok;
+  } else {
+    std::ofstream out(tmp, std::ios::binary);
+    out << content;
+    out.close();
+    ok = static_cast<bool>(out);
+  }
+  if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+/*! \brief Returns the path of the executable and its size and time. */
+std::string
+describeExecutable(const char *argv0) {
+  static int anchor;
+  const auto path = sys::fs::getMainExecutable(argv0, &anchor);
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return path;
+  }
+  return path + " " + std::to_string(st.st_size) + " "
+      + std::to_string(st.st_mtime);
+}
+
+std::string
+getCurrentDirectory() {
+  char cwd[BUFSIZ];
+  return getcwd(cwd, sizeof cwd) ? cwd : "";
+}
+
+} // namespace
+
+ResultCache::ResultCache(const char *argv0,
+    const std::vector<std::string> &toolArgs,
+    const std::vector<std::string> &inputFiles)
+    : dir(OptCacheDir), isPending(false), pendingStart(0) {
+  std::fill(counters, counters + NumCounters, 0);
+  if (!isEnabled()) {
+    return;
+  }
+  if (sys::fs::create_directories(dir)) {
+    errs() << "-cache-dir: cannot create " << dir << "\n";
+    exit(1);
+  }
+  Hasher hasher;
+  hasher.add(cacheFormat);
+  hasher.add(clang::getClangFullVersion());
+  hasher.add(describeExecutable(argv0));
+  for (auto &arg : toolArgs) {
+    hasher.add(arg);
+  }
+  for (auto &file : inputFiles) {
+    // an unreadable file hashes as empty; loading it fails anyway
+    std::string content;
+    readFile(file, content);
+    hasher.add(file);
+    hasher.add(content);
+  }
+  hasher.add(getCurrentDirectory());
+  toolKey = hasher.final();
+}
+
+bool
+ResultCache::isEnabled() {
+  return !OptCacheDir.empty();
+}
+
+std::string
+ResultCache::getPath(const std::string &key, const char *suffix) const {
+  return dir + "/" + key.substr(0, 2) + "/" + key + suffix;
+}
+
+bool
+ResultCache::hashFile(const std::string &path, std::string &hash) {
+  const auto iter = fileHashes.find(path);
+  if (iter != fileHashes.end()) {
+    hash = iter->second;
+    return !hash.empty();
+  }
+  std::string content;
+  if (!readFile(path, content)) {
+    fileHashes[path] = "";
+    return false;
+  }
+  Hasher hasher;
+  hasher.add(content);
+  hash = fileHashes[path] = hasher.final();
+  return true;
+}
+
+/*
+ * A manifest is a sequence of entries:
+ *   result <result key>
+ *   file <hash> <path>
+ *   ...
+ *   end
+ */
+bool
+ResultCache::readManifest(
+    const std::string &key, std::vector<Entry> &entries) {
+  std::ifstream in(getPath(key, ".manifest"));
+  if (!in) {
+    return false;
+  }
+  std::string line;
+  Entry entry;
+  while (std::getline(in, line)) {
+    if (line.compare(0, 7, "result ") == 0) {
+      entry = Entry();
+      entry.resultKey = line.substr(7);
+    } else if (line.compare(0, 5, "file ") == 0) {
+      const auto space = line.find(' ', 5);
+      if (space == std::string::npos) {
+        return false;
+      }
+      entry.files.emplace_back(
+          line.substr(space + 1), line.substr(5, space - 5));
+    } else if (line == "end") {
+      entries.push_back(entry);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+void
+ResultCache::writeManifest(
+    const std::string &key, const std::vector<Entry> &entries) {
+  std::string content;
+  for (auto &entry : entries) {
+    content += "result " + entry.resultKey + "\n";
+    for (auto &file : entry.files) {
+      content += "file " + file.second + " " + file.first + "\n";
+    }
+    content += "end\n";
+  }
+  writeFileAtomically(getPath(key, ".manifest"), content, false);
+}
+
+bool
+ResultCache::isUpToDate(const Entry &entry) {
+  std::string hash;
+  for (auto &file : entry.files) {
+    if (!hashFile(file.first, hash) || hash != file.second) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+ResultCache::lookup(const std::string &source,
+    const std::string &compileCommand,
+    std::string &xml) {
+  isPending = false;
+  std::string sourceHash;
+  if (!hashFile(source, sourceHash)) {
+    // let clang report the error
+    ++counters[Misses];
+    return false;
+  }
+  Hasher hasher;
+  hasher.add(toolKey);
+  hasher.add(compileCommand);
+  hasher.add(source);
+  hasher.add(sourceHash);
+  const auto key = hasher.final();
+
+  std::vector<Entry> entries;
+  readManifest(key, entries);
+  for (auto &entry : entries) {
+    if (!isUpToDate(entry)) {
+      continue;
+    }
+    const auto resultPath = getPath(entry.resultKey, ".xml.gz");
+    if (readCompressedFile(resultPath, xml)) {
+      // mark them recently used
+      utime(resultPath.c_str(), nullptr);
+      utime(getPath(key, ".manifest").c_str(), nullptr);
+      ++counters[Hits];
+      return true;
+    }
+  }
+  ++counters[Misses];
+  isPending = true;
+  pendingKey = key;
+  pendingStart = std::time(nullptr);
+  pendingDependencies.clear();
+  pendingXml.clear();
+  return false;
+}
+
+void
+ResultCache::addResult(
+    const std::vector<std::string> &dependencies, const std::string &xml) {
+  if (!isPending) {
+    return;
+  }
+  pendingDependencies.insert(dependencies.begin(), dependencies.end());
+  pendingXml += xml;
+}
+
+void
+ResultCache::commit(bool succeeded) {
+  if (!isPending || !succeeded || pendingXml.empty()) {
+    isPending = false;
+    return;
+  }
+  isPending = false;
+
+  Entry entry;
+  Hasher hasher;
+  hasher.add(pendingKey);
+  for (auto &path : pendingDependencies) {
+    // The file is hashed now, so a change made after clang read it
+    // would be recorded with the output of the old content.
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || st.st_mtime >= pendingStart) {
+      return; // gone or too new: do not cache
+    }
+    std::string hash;
+    if (!hashFile(path, hash)) {
+      return; // the file has gone: do not cache
+    }
+    entry.files.emplace_back(path, hash);
+    hasher.add(path);
+    hasher.add(hash);
+  }
+  entry.resultKey = hasher.final();
+
+  mkdir((dir + "/" + pendingKey.substr(0, 2)).c_str(), 0777);
+  mkdir((dir + "/" + entry.resultKey.substr(0, 2)).c_str(), 0777);
+  if (!writeFileAtomically(
+          getPath(entry.resultKey, ".xml.gz"), pendingXml, true)) {
+    return;
+  }
+  std::vector<Entry> entries{entry};
+  std::vector<Entry> oldEntries;
+  readManifest(pendingKey, oldEntries);
+  for (auto &old : oldEntries) {
+    if (entries.size() < maxManifestEntries
+        && old.resultKey != entry.resultKey) {
+      entries.push_back(old);
+    }
+  }
+  writeManifest(pendingKey, entries);
+  ++counters[Stores];
+  evict();
+}
+
+void
+ResultCache::evict() {
+  struct CachedFile {
+    std::string path;
+    off_t size;
+    time_t time;
+  };
+  std::vector<CachedFile> files;
+  unsigned long long total = 0;
+
+  DIR *top = opendir(dir.c_str());
+  if (!top) {
+    return;
+  }
+  while (const auto sub = readdir(top)) {
+    if (std::strlen(sub->d_name) != 2) {
+      continue; // ".", "..", "stats"
+    }
+    const auto subdir = dir + "/" + sub->d_name;
+    DIR *d = opendir(subdir.c_str());
+    if (!d) {
+      continue;
+    }
+    while (const auto ent = readdir(d)) {
+      const auto path = subdir + "/" + ent->d_name;
+      struct stat st;
+      if (ent->d_name[0] == '.' || stat(path.c_str(), &st) != 0
+          || !S_ISREG(st.st_mode)) {
+        continue;
+      }
+      files.push_back(CachedFile{path, st.st_size, st.st_mtime});
+      total += st.st_size;
+    }
+    closedir(d);
+  }
+  closedir(top);
+
+  const unsigned long long limit = OptCacheMaxSize * 1024ULL * 1024ULL;
+  if (total <= limit) {
+    return;
+  }
+  // Remove the least recently used files until 90% of the limit,
+  // so that eviction does not run after every store.
+  std::sort(files.begin(),
+      files.end(),
+      [](const CachedFile &a, const CachedFile &b) {
+        return a.time < b.time;
+      });
+  for (auto &file : files) {
+    if (total <= limit / 10 * 9) {
+      break;
+    }
+    if (std::remove(file.path.c_str()) == 0) {
+      total -= file.size;
+      ++counters[Evictions];
+    }
+  }
+}
+
+void
+ResultCache::finish() {
+  if (!isEnabled()) {
+    return;
+  }
+  // The counters are merged by read-modify-write;
+  // concurrent runs may lose some counts.
+  unsigned long totals[NumCounters] = {};
+  std::ifstream in(dir + "/stats");
+  std::string name;
+  unsigned long value;
+  while (in >> name >> value) {
+    for (int i = 0; i < NumCounters; ++i) {
+      if (name == counterNames[i]) {
+        totals[i] = value;
+      }
+    }
+  }
+  std::string content;
+  for (int i = 0; i < NumCounters; ++i) {
+    totals[i] += counters[i];
+    content += std::string(counterNames[i]) + " "
+        + std::to_string(totals[i]) + "\n";
+  }
+  writeFileAtomically(dir + "/stats", content, false);
+
+  if (!OptCacheStats) {
+    return;
+  }
+  for (int i = 0; i < NumCounters; ++i) {
+    errs() << "cache " << counterNames[i] << ": " << counters[i]
+           << " (total " << totals[i] << ")\n";
+  }
+}
+
+///
+/// Local Variables:
+/// indent-tabs-mode: nil
+/// c-basic-offset: 2
+/// End:
+///
@@ -0,0 +1,126 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <ctime>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/*!
+ * \brief On-disk cache of the output of CXXtoXML, enabled by
+ * `-cache-dir`.
+ *
+ * It works like the direct mode of ccache. The direct key of a source
+ * file is the hash of the tool (clang version and executable), the
+ * options of CXXtoXML, the compile command, the working directory and
+ * the content of the file, and the contents of the files named by the
+ * options (`inputFiles`, e.g. the `-typenamemap` file), which clang
+ * does not see being read. The manifest stored under the direct key
+ * lists the files the earlier conversions read (the main file and
+ * every included file, with the hashes of their contents) and the
+ * result produced from them. A lookup hits if all the files of an
+ * entry still have the recorded hashes; the stored XML is then written
+ * without parsing the source.
+ *
+ * As ccache does, a result is not stored if a file it was built from
+ * was modified after the conversion began, since the file may have
+ * been read before the change.
+ *
+ * Layout of the cache directory (`xx` is the first two hex digits of
+ * the key):
+ * - `xx/<direct key>.manifest`
+ * - `xx/<result key>.xml.gz`
+ * - `stats`: the counters accumulated over all runs
+ *
+ * When the files exceed `-cache-max-size`, the least recently used
+ * ones are removed.
+ */
+class ResultCache {
+public:
+  ResultCache() = delete;
+  ResultCache(const ResultCache &) = delete;
+  ResultCache(ResultCache &&) = delete;
+  ResultCache &operator=(const ResultCache &) = delete;
+  ResultCache &operator=(ResultCache &&) = delete;
+
+  /*!
+   * \param argv0 `argv[0]` of CXXtoXML, to identify the executable
+   * \param toolArgs the arguments of CXXtoXML except the source files
+   * \param inputFiles the files the options name whose contents affect
+   * the output; an option that names such a file must add it here
+   */
+  ResultCache(const char *argv0,
+      const std::vector<std::string> &toolArgs,
+      const std::vector<std::string> &inputFiles);
+
+  /*! \brief Returns true if `-cache-dir` is given. */
+  static bool isEnabled();
+
+  /*!
+   * \brief Looks up the output for `source`.
+   *
+   * `compileCommand` identifies how the file is compiled (the
+   * directory and the arguments from the compilation database).
+   * On a hit, sets `xml` and returns true. On a miss, the output
+   * passed to addResult() until commit() is stored for `source`.
+   */
+  bool lookup(const std::string &source,
+      const std::string &compileCommand,
+      std::string &xml);
+
+  /*!
+   * \brief Records the output of a conversion that missed and the files
+   * it read.
+   *
+   * Not called for an output that is not determined by those files
+   * (e.g. it expands `__DATE__`), which is then not stored.
+   */
+  void addResult(
+      const std::vector<std::string> &dependencies, const std::string &xml);
+
+  /*!
+   * \brief Stores the recorded output if the conversion `succeeded`,
+   * then removes old files if the cache is too large.
+   */
+  void commit(bool succeeded);
+
+  /*!
+   * \brief Adds the counters of this run to the `stats` file, and
+   * prints them if `-cache-stats` is given.
+   */
+  void finish();
+
+private:
+  struct Entry {
+    std::string resultKey;
+    /*! (path, hash of content) */
+    std::vector<std::pair<std::string, std::string>> files;
+  };
+
+  std::string getPath(const std::string &key, const char *suffix) const;
+  bool hashFile(const std::string &path, std::string &hash);
+  bool readManifest(const std::string &key, std::vector<Entry> &entries);
+  void writeManifest(
+      const std::string &key, const std::vector<Entry> &entries);
+  bool isUpToDate(const Entry &entry);
+  void evict();
+
+  std::string dir;
+  /*! the hash of everything but the source file */
+  std::string toolKey;
+  /*! the hashes of the files read in this run, by path */
+  std::map<std::string, std::string> fileHashes;
+
+  bool isPending;
+  std::string pendingKey;
+  /*! when the lookup of the pending conversion missed */
+  std::time_t pendingStart;
+  std::set<std::string> pendingDependencies;
+  std::string pendingXml;
+
+  enum Counter { Hits, Misses, Stores, Evictions, NumCounters };
+  unsigned long counters[NumCounters];
+};
+
+#endif /* !RESULTCACHE_H */
@@ -0,0 +1,139 @@
+#include <cstddef>
+#include <string>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "StringEscape.h"
+
+namespace {
+
+bool
+needsEscape(unsigned char c) {
+  return c < 0x20 || c >= 0x7f || c == '"' || c == '\\';
+}
+
+void
+appendEscaped(unsigned char c, std::string &out) {
+  switch (c) {
+  case '"': out += "\\\""; return;
+  case '\\': out += "\\\\"; return;
+  case '\b': out += "\\b"; return;
+  case '\f': out += "\\f"; return;
+  case '\n': out += "\\n"; return;
+  case '\r': out += "\\r"; return;
+  case '\t': out += "\\t"; return;
+  default: break;
+  }
+  const char octal[] = {'\\',
+      static_cast<char>('0' + ((c >> 6) & 0x7)),
+      static_cast<char>('0' + ((c >> 3) & 0x7)),
+      static_cast<char>('0' + (c & 0x7))};
+  out.append(octal, sizeof(octal));
+}
+
+#if defined(__AVX2__)
+/*!
+ * \brief Returns the length of the longest prefix of `[p, end)` that
+ * needs no escaping, examining 32 bytes at a time.
+ */
+size_t
+countPlainBytes(const char *p, const char *end) {
+  const char *const begin = p;
+  // As signed bytes, c < 0x20 || c >= 0x80 is equivalent to c < 0x20.
+  const __m256i space = _mm256_set1_epi8(0x20);
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  for (; end - p >= 32; p += 32) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    const __m256i special = _mm256_or_si256(
+        _mm256_or_si256(
+            _mm256_cmpgt_epi8(space, v), _mm256_cmpeq_epi8(v, del)),
+        _mm256_or_si256(
+            _mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)));
+    const unsigned mask = _mm256_movemask_epi8(special);
+    if (mask) {
+      return p - begin + __builtin_ctz(mask);
+    }
+  }
+  while (p != end && !needsEscape(*p)) {
+    ++p;
+  }
+  return p - begin;
+}
+#elif defined(__SSE2__)
+/*!
+ * \brief Returns the length of the longest prefix of `[p, end)` that
+ * needs no escaping, examining 16 bytes at a time.
+ */
+size_t
+countPlainBytes(const char *p, const char *end) {
+  const char *const begin = p;
+  // As signed bytes, c < 0x20 || c >= 0x80 is equivalent to c < 0x20.
+  const __m128i space = _mm_set1_epi8(0x20);
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  for (; end - p >= 16; p += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpeq_epi8(v, del)),
+        _mm_or_si128(
+            _mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+    const unsigned mask = _mm_movemask_epi8(special);
+    if (mask) {
+      return p - begin + __builtin_ctz(mask);
+    }
+  }
+  while (p != end && !needsEscape(*p)) {
+    ++p;
+  }
+  return p - begin;
+}
+#else
+size_t
+countPlainBytes(const char *p, const char *end) {
+  const char *const begin = p;
+  while (p != end && !needsEscape(*p)) {
+    ++p;
+  }
+  return p - begin;
+}
+#endif
+
+} // namespace
+
+void
+escapeStringLiteral(const char *data, size_t size, std::string &out) {
+  out.reserve(out.size() + size);
+  const char *p = data;
+  const char *const end = data + size;
+  while (p != end) {
+    const size_t n = countPlainBytes(p, end);
+    out.append(p, n);
+    p += n;
+    if (p != end) {
+      appendEscaped(*p++, out);
+    }
+  }
+}
+
+void
+escapeStringLiteralScalar(const char *data, size_t size, std::string &out) {
+  for (size_t i = 0; i < size; ++i) {
+    const unsigned char c = data[i];
+    if (needsEscape(c)) {
+      appendEscaped(c, out);
+    } else {
+      out += static_cast<char>(c);
+    }
+  }
+}
+
+///
+/// Local Variables:
+/// indent-tabs-mode: nil
+/// c-basic-offset: 2
+/// End:
+///
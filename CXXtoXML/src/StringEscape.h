@@ -0,0 +1,24 @@
+#ifndef STRINGESCAPE_H
+#define STRINGESCAPE_H
+
+/*!
+ * \brief Appends the bytes `[data, data + size)` to `out`, escaped as
+ * the body of a C string literal.
+ *
+ * `"` and `\` are backslash-escaped, `\b`, `\f`, `\n`, `\r` and `\t`
+ * use their short forms, and the other bytes outside the printable
+ * ASCII range become three-digit octal escapes.
+ * Runs of bytes that need no escaping are copied with SSE2 or AVX2
+ * when the compiler targets them.
+ */
+void escapeStringLiteral(const char *data, size_t size, std::string &out);
+
+/*!
+ * \brief Same as `escapeStringLiteral`, one byte at a time.
+ *
+ * Kept as the reference for tests and benchmarks.
+ */
+void escapeStringLiteralScalar(
+    const char *data, size_t size, std::string &out);
+
+#endif /* !STRINGESCAPE_H */
@@ -0,0 +1,149 @@
+#include <libxml/tree.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "LibXMLUtil.h"
+#include "TypeTableDedup.h"
+
+namespace {
+
+/*! \brief Whether entries of this element are compared by structure. */
+bool
+isStructural(xmlNodePtr entry) {
+  return isElement(entry, "basicType") || isElement(entry, "pointerType")
+      || isElement(entry, "functionType") || isElement(entry, "arrayType");
+}
+
+/*! \brief Maps a type name to the name of the entry that replaces it. */
+using Renaming = std::unordered_map<std::string, std::string>;
+
+const char *
+rename(const Renaming &renaming, const char *value) {
+  const auto iter = renaming.find(value);
+  return iter == renaming.end() ? value : iter->second.c_str();
+}
+
+/*!
+ * \brief Appends to `key` the structure of `node` with the names in
+ * `renaming` replaced, leaving out the attribute `ownName` of `node`.
+ *
+ * Names and values are separated by bytes that XML content cannot
+ * hold, so that distinct structures have distinct keys.
+ */
+void
+appendKey(xmlNodePtr node,
+    const char *ownName,
+    const Renaming &renaming,
+    std::string &key) {
+  if (node->type == XML_TEXT_NODE || node->type == XML_CDATA_SECTION_NODE) {
+    key += '\2';
+    key += reinterpret_cast<const char *>(node->content);
+    return;
+  }
+  if (node->type != XML_ELEMENT_NODE) {
+    return;
+  }
+  key += '\3';
+  key += reinterpret_cast<const char *>(node->name);
+  for (auto attr = node->properties; attr; attr = attr->next) {
+    if (ownName && xmlStrEqual(attr->name, BAD_CAST ownName)) {
+      continue;
+    }
+    key += '\4';
+    key += reinterpret_cast<const char *>(attr->name);
+    key += '\5';
+    if (attr->children && attr->children->content) {
+      key += rename(renaming,
+          reinterpret_cast<const char *>(attr->children->content));
+    }
+  }
+  for (auto child = node->children; child; child = child->next) {
+    appendKey(child, nullptr, renaming, key);
+  }
+  key += '\6';
+}
+
+void
+renameAttributes(xmlNodePtr node, const Renaming &renaming) {
+  for (auto attr = node->properties; attr; attr = attr->next) {
+    if (!attr->children || !attr->children->content) {
+      continue;
+    }
+    const auto iter = renaming.find(
+        reinterpret_cast<const char *>(attr->children->content));
+    if (iter != renaming.end()) {
+      xmlNodeSetContent(attr->children, BAD_CAST iter->second.c_str());
+    }
+  }
+  for (auto child = node->children; child; child = child->next) {
+    if (child->type == XML_ELEMENT_NODE) {
+      renameAttributes(child, renaming);
+    }
+  }
+}
+
+} // namespace
+
+size_t
+deduplicateTypeTable(xmlNodePtr program) {
+  const auto ast = findChild(program, "clangAST");
+  const auto translationUnit =
+      ast ? findChild(ast, "clangDecl", "TranslationUnit") : nullptr;
+  const auto table = translationUnit
+      ? findChild(translationUnit, "xcodemlTypeTable")
+      : nullptr;
+  if (!table) {
+    return 0;
+  }
+  std::vector<xmlNodePtr> entries;
+  for (auto child = table->children; child; child = child->next) {
+    if (child->type == XML_ELEMENT_NODE && isStructural(child)
+        && findProp(child, "type")) {
+      entries.push_back(child);
+    }
+  }
+
+  // Merging two entries can make the entries that refer to them equal,
+  // so repeat until nothing changes; the number of rounds is bounded
+  // by the depth of the types, since no structural type refers to
+  // itself but through a class.
+  Renaming renaming;
+  std::vector<bool> isMerged(entries.size());
+  for (bool changed = true; changed;) {
+    changed = false;
+    std::unordered_map<std::string, const char *> firstByKey;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      if (isMerged[i]) {
+        continue;
+      }
+      std::string key;
+      appendKey(entries[i], "type", renaming, key);
+      const auto name = findProp(entries[i], "type");
+      const auto first = firstByKey.emplace(std::move(key), name).first;
+      if (first->second != name) {
+        renaming[name] = first->second;
+        isMerged[i] = true;
+        changed = true;
+      }
+    }
+  }
+  if (renaming.empty()) {
+    return 0;
+  }
+  // A chain of renamings ends at an entry that is kept.
+  for (auto &r : renaming) {
+    for (auto iter = renaming.find(r.second); iter != renaming.end();
+         iter = renaming.find(r.second)) {
+      r.second = iter->second;
+    }
+  }
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (isMerged[i]) {
+      xmlUnlinkNode(entries[i]);
+      xmlFreeNode(entries[i]);
+    }
+  }
+  renameAttributes(program, renaming);
+  return renaming.size();
+}
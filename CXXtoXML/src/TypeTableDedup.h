@@ -0,0 +1,26 @@
+#ifndef TYPETABLEDEDUP_H
+#define TYPETABLEDEDUP_H
+
+/*!
+ * \brief Merges the entries of the `<xcodemlTypeTable>` of `program`
+ * (`<Program>`) that are structurally identical, enabled by
+ * `-dedup-types`.
+ *
+ * Types that differ only in sugar (typedefs, parentheses, elaborated
+ * or decayed types) are registered under distinct names, but may be
+ * written as the same `basicType`, `pointerType`, `functionType` or
+ * `arrayType`. Two such entries are merged if they have the same
+ * element, attributes and children once the names they refer to are
+ * replaced with the names of the merged entries. The first entry is
+ * kept, and the attributes of the whole document that name the others
+ * are rewritten to its name.
+ *
+ * Class, struct, union and enum types are distinct types however they
+ * are written, and the other entries carry too little to be compared,
+ * so they are left alone.
+ *
+ * Returns the number of entries removed.
+ */
+size_t deduplicateTypeTable(xmlNodePtr program);
+
+#endif /* !TYPETABLEDEDUP_H */
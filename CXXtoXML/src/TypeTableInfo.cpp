@@ -2,13 +2,18 @@
 #include "DeclarationsVisitor.h"
 #include "ClangOperator.h"
 #include "TypeTableInfo.h"
+#include "DeclFilter.h"
 #include "XcodeMlNameElem.h"
+#include "FileTableInfo.h"
+#include "ParallelTraversal.h"
+#include "TimeReport.h"
 
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <map>
 #include <cctype>
+#include <cstdio>
 
 using namespace clang;
 using namespace llvm;
@@ -31,15 +36,60 @@ static cl::opt<std::string> OptTypeNameMap("typenamemap",
     cl::desc("a map file of typename substitution"),
     cl::cat(CXX2XMLCategory));
 
-static std::ifstream mapfile;
-static bool map_is_already_set = false;
-static std::map<std::string, std::string> typenamemap;
+using TypeNameMap = std::map<std::string, std::string>;
 
-TypeTableInfo::TypeTableInfo(MangleContext *MC, InheritanceInfo *II)
-    : mangleContext(MC), inheritanceinfo(II) {
-  mapFromNameToQualType.clear();
-  mapFromQualTypeToName.clear();
-  mapFromQualTypeToXmlNodePtr.clear();
+const std::string &
+TypeTableInfo::getTypeNameMapFile() {
+  return OptTypeNameMap;
+}
+
+static TypeNameMap
+loadTypeNameMap() {
+  TypeNameMap typenamemap;
+  if (OptTypeNameMap.empty()) {
+    return typenamemap;
+  }
+  std::cerr << "use " << OptTypeNameMap << " as a typenamemap file"
+            << std::endl;
+  std::ifstream mapfile(OptTypeNameMap);
+  if (mapfile.fail()) {
+    std::cerr << OptTypeNameMap << ": cannot open" << std::endl;
+    exit(1);
+  }
+  std::string line;
+  while (std::getline(mapfile, line)) {
+    std::istringstream iss(line);
+    std::string lhs, rhs;
+    iss >> lhs >> rhs;
+    if (!iss) {
+      std::cerr << OptTypeNameMap << ": read error" << std::endl;
+      exit(1);
+    }
+    typenamemap[lhs] = rhs;
+  }
+  return typenamemap;
+}
+
+/*!
+ * \brief Returns the substitutions given by -typenamemap,
+ * reading the file on the first call.
+ */
+static const TypeNameMap &
+getTypeNameMap() {
+  static const TypeNameMap typenamemap = loadTypeNameMap();
+  return typenamemap;
+}
+
+static const std::string &
+substituteTypeName(const std::string &name) {
+  const auto &typenamemap = getTypeNameMap();
+  const auto iter = typenamemap.find(name);
+  return iter != typenamemap.end() ? iter->second : name;
+}
+
+TypeTableInfo::TypeTableInfo(
+    MangleContext *MC, InheritanceInfo *II, DeclFilter *DF)
+    : mangleContext(MC), inheritanceinfo(II), declfilter(DF) {
   seqForBasicType = 0;
   seqForPointerType = 0;
   seqForFunctionType = 0;
@@ -50,108 +100,282 @@ TypeTableInfo::TypeTableInfo(MangleContext *MC, InheritanceInfo *II)
   seqForClassType = 0;
   seqForOtherType = 0;
 
-  TypeElements.clear();
   useLabelType = false;
+  usePlaceholderNames = false;
+  getTypeNameMap(); // report a bad -typenamemap file before traversal
+}
+
+TypeTableInfo::TypeRecord *
+TypeTableInfo::findRecord(QualType T) {
+  const auto index = mapFromQualTypeToRecord.find(T.getAsOpaquePtr());
+  return index ? &typeRecords[*index] : nullptr;
+}
+
+TypeTableInfo::TypeRecord &
+TypeTableInfo::getOrCreateRecord(QualType T) {
+  const auto result = mapFromQualTypeToRecord.insert(
+      T.getAsOpaquePtr(), static_cast<unsigned>(typeRecords.size()));
+  if (result.second) {
+    typeRecords.push_back(TypeRecord{T, noName, nullptr, false, false});
+  }
+  return typeRecords[*result.first];
+}
+
+const std::string &
+TypeTableInfo::setTypeName(QualType T, const std::string &name) {
+  auto &record = getOrCreateRecord(T);
+  assert(record.nameId == noName);
+  record.nameId = typeNames.size();
+  typeNames.push_back(substituteTypeName(name));
+  return typeNames.back();
+}
+
+/*!
+ * \brief Returns the 64-bit FNV-1a hash of `s`. Unlike std::hash and
+ * llvm::hash_value, it is the same in every run and on every host.
+ */
+static uint64_t
+hashStably(const std::string &s) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (const unsigned char c : s) {
+    h ^= c;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
 }
 
 std::string
-TypeTableInfo::registerBasicType(QualType T) {
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+TypeTableInfo::makeStableName(
+    const std::string &prefix, const std::string &spelling) {
+  char hex[17];
+  snprintf(hex,
+      sizeof hex,
+      "%016llx",
+      static_cast<unsigned long long>(hashStably(prefix + spelling)));
+  const auto name = prefix + hex;
+  if (stableNames.insert(name).second) {
+    return name;
+  }
+  // Distinct entities still spelled alike (e.g. tags declared by
+  // one macro expansion) are numbered in the order of registration.
+  for (unsigned n = 1;; ++n) {
+    const auto candidate = name + "_" + std::to_string(n);
+    if (stableNames.insert(candidate).second) {
+      return candidate;
+    }
+  }
+}
 
-  raw_string_ostream OS(name);
-  OS << "Basic" << seqForBasicType++;
-  return mapFromQualTypeToName[T] = OS.str();
+void
+TypeTableInfo::enablePlaceholderNames() {
+  usePlaceholderNames = true;
 }
 
 std::string
-TypeTableInfo::registerPointerType(QualType T) {
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+TypeTableInfo::makePlaceholderName(const void *key, bool isNns) {
+  placeholderNames.emplace_back(key, isNns);
+  return ::makePlaceholderName(placeholderNames.size() - 1);
+}
+
+/*!
+ * \brief Returns true if `TD` may print the same as another tag: it is
+ * unnamed (as lambdas are), or declared in a function or in such a tag.
+ */
+static bool
+isSpelledAmbiguously(const TagDecl *TD) {
+  for (const DeclContext *DC = TD; DC; DC = DC->getParent()) {
+    if (DC->isFunctionOrMethod()) {
+      return true;
+    }
+    const auto Tag = dyn_cast<TagDecl>(DC);
+    if (Tag && !Tag->getIdentifier() && !Tag->getTypedefNameForAnonDecl()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void appendTagLocations(
+    const SourceManager &SM, QualType T, std::string &out);
+
+static void
+appendTagLocations(
+    const SourceManager &SM, const TemplateArgument &arg, std::string &out) {
+  switch (arg.getKind()) {
+  case TemplateArgument::Type:
+    appendTagLocations(SM, arg.getAsType(), out);
+    break;
+  case TemplateArgument::Pack:
+    for (const auto &element : arg.pack_elements()) {
+      appendTagLocations(SM, element, out);
+    }
+    break;
+  default: break;
+  }
+}
+
+static void
+appendTagLocations(
+    const SourceManager &SM, const TagDecl *TD, std::string &out) {
+  TD = TD->getCanonicalDecl();
+  if (isSpelledAmbiguously(TD)) {
+    // as in the output: the location does not depend on how the file
+    // was named on the command line
+    const auto loc =
+        SM.getPresumedLoc(SM.getExpansionLoc(TD->getLocation()));
+    if (loc.isValid()) {
+      out += " @" + FileTableInfo::normalizeFileName(loc.getFilename())
+          + ":" + std::to_string(loc.getLine()) + ":"
+          + std::to_string(loc.getColumn());
+    }
+  }
+  for (const DeclContext *DC = TD; DC; DC = DC->getParent()) {
+    if (const auto CTSD = dyn_cast<ClassTemplateSpecializationDecl>(DC)) {
+      for (const auto &arg : CTSD->getTemplateArgs().asArray()) {
+        appendTagLocations(SM, arg, out);
+      }
+    }
+  }
+}
+
+/*!
+ * \brief Appends the location of each tag in `T` (or in its template
+ * arguments) that isSpelledAmbiguously.
+ */
+static void
+appendTagLocations(const SourceManager &SM, QualType T, std::string &out) {
+  if (T.isNull()) {
+    return;
+  }
+  const auto type = T.getCanonicalType().getTypePtr();
+  if (const auto PT = dyn_cast<PointerType>(type)) {
+    appendTagLocations(SM, PT->getPointeeType(), out);
+  } else if (const auto BPT = dyn_cast<BlockPointerType>(type)) {
+    appendTagLocations(SM, BPT->getPointeeType(), out);
+  } else if (const auto RT = dyn_cast<ReferenceType>(type)) {
+    appendTagLocations(SM, RT->getPointeeType(), out);
+  } else if (const auto MPT = dyn_cast<MemberPointerType>(type)) {
+    appendTagLocations(SM, QualType(MPT->getClass(), 0), out);
+    appendTagLocations(SM, MPT->getPointeeType(), out);
+  } else if (const auto AT = dyn_cast<ArrayType>(type)) {
+    appendTagLocations(SM, AT->getElementType(), out);
+  } else if (const auto VT = dyn_cast<VectorType>(type)) {
+    appendTagLocations(SM, VT->getElementType(), out);
+  } else if (const auto FT = dyn_cast<FunctionType>(type)) {
+    appendTagLocations(SM, FT->getReturnType(), out);
+    if (const auto FPT = dyn_cast<FunctionProtoType>(FT)) {
+      for (const auto param : FPT->getParamTypes()) {
+        appendTagLocations(SM, param, out);
+      }
+    }
+  } else if (const auto TST = dyn_cast<TemplateSpecializationType>(type)) {
+    for (unsigned i = 0; i < TST->getNumArgs(); ++i) {
+      appendTagLocations(SM, TST->getArg(i), out);
+    }
+  } else if (const auto TT = dyn_cast<TagType>(type)) {
+    appendTagLocations(SM, TT->getDecl(), out);
+  }
+}
+
+void
+TypeTableInfo::appendTagLocations(QualType T, std::string &spelling) const {
+  ::appendTagLocations(
+      mangleContext->getASTContext().getSourceManager(), T, spelling);
+}
 
-  raw_string_ostream OS(name);
+std::string
+TypeTableInfo::makeTypeName(QualType T, const char *prefix, int &seq) {
+  if (usePlaceholderNames) {
+    // T is canonical: the other types share the name of their
+    // canonical types.
+    return makePlaceholderName(T.getAsOpaquePtr(), false);
+  }
+  if (!OptReproducible) {
+    return prefix + std::to_string(seq++);
+  }
+  PrintingPolicy PP(mangleContext->getASTContext().getLangOpts());
+  // the location depends on how the file was named on the command line
+  PP.AnonymousTagLocations = false;
+  auto spelling = T.getAsString(PP);
+  appendTagLocations(T, spelling);
+  return makeStableName(prefix, spelling);
+}
+
+std::string
+TypeTableInfo::registerBasicType(QualType T) {
+  return setTypeName(T, makeTypeName(T, "Basic", seqForBasicType));
+}
+
+std::string
+TypeTableInfo::registerPointerType(QualType T) {
+  std::string name;
   switch (T->getTypeClass()) {
   case Type::Pointer:
   case Type::BlockPointer:
   case Type::LValueReference:
   case Type::RValueReference:
-  case Type::MemberPointer: OS << "Pointer" << seqForPointerType++; break;
+  case Type::MemberPointer:
+    name = makeTypeName(T, "Pointer", seqForPointerType);
+    break;
   default: abort();
   }
-  return mapFromQualTypeToName[T] = OS.str();
+  return setTypeName(T, name);
 }
 
 std::string
 TypeTableInfo::registerFunctionType(QualType T) {
   assert(T->getTypeClass() == Type::FunctionProto
       || T->getTypeClass() == Type::FunctionNoProto);
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
-
-  raw_string_ostream OS(name);
-  OS << "Function" << seqForFunctionType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return setTypeName(T, makeTypeName(T, "Function", seqForFunctionType));
 }
 
 std::string
 TypeTableInfo::registerArrayType(QualType T) {
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
-
-  raw_string_ostream OS(name);
+  std::string name;
   switch (T->getTypeClass()) {
-  case Type::ConstantArray: OS << "ConstantArray" << seqForArrayType++; break;
+  case Type::ConstantArray:
+    name = makeTypeName(T, "ConstantArray", seqForArrayType);
+    break;
   case Type::IncompleteArray:
-    OS << "ImcompleteArray" << seqForArrayType++;
+    name = makeTypeName(T, "ImcompleteArray", seqForArrayType);
+    break;
+  case Type::VariableArray:
+    name = makeTypeName(T, "VariableArray", seqForArrayType);
     break;
-  case Type::VariableArray: OS << "VariableArray" << seqForArrayType++; break;
   case Type::DependentSizedArray:
-    OS << "DependentSizeArray" << seqForArrayType++;
+    name = makeTypeName(T, "DependentSizeArray", seqForArrayType);
     break;
   default: abort();
   }
-  return mapFromQualTypeToName[T] = OS.str();
+  return setTypeName(T, name);
 }
 
 std::string
 TypeTableInfo::registerRecordType(QualType T) {
   assert(T->getTypeClass() == Type::Record);
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
-
-  raw_string_ostream OS(name);
+  std::string name;
   if (T->getAsCXXRecordDecl()) {
-    OS << "Class" << seqForStructType++;
+    name = makeTypeName(T, "Class", seqForStructType);
     // XXX: temporary implementation
   } else if (T->isStructureType()) {
-    OS << "Struct" << seqForStructType++;
+    name = makeTypeName(T, "Struct", seqForStructType);
   } else if (T->isUnionType()) {
-    OS << "Union" << seqForUnionType++;
+    name = makeTypeName(T, "Union", seqForUnionType);
   } else {
     abort();
   }
-  return mapFromQualTypeToName[T] = OS.str();
+  return setTypeName(T, name);
 }
 
 std::string
 TypeTableInfo::registerEnumType(QualType T) {
   assert(T->getTypeClass() == Type::Enum);
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
-
-  raw_string_ostream OS(name);
-  OS << "Enum" << seqForEnumType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return setTypeName(T, makeTypeName(T, "Enum", seqForEnumType));
 }
 
 std::string
 TypeTableInfo::registerOtherType(QualType T) {
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
-
-  raw_string_ostream OS(name);
-  OS << "Other" << seqForOtherType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return setTypeName(T, makeTypeName(T, "Other", seqForOtherType));
 }
 
 xmlNodePtr
@@ -164,7 +388,9 @@ TypeTableInfo::createNode(QualType T, const char *fieldname, xmlNodePtr) {
 void
 TypeTableInfo::pushType(const QualType &T, xmlNodePtr node) {
   std::get<1>(typeTableStack.top()).push_back(T);
-  TypeElements[T] = node;
+  auto &record = getOrCreateRecord(T);
+  record.node = node;
+  record.isPending = true;
 }
 
 static const char *
@@ -194,6 +420,11 @@ makeSymbolsNodeForCXXRecordDecl(TypeTableInfo &TTI, const CXXRecordDecl *RD) {
   }
 
   // static or non-static member functions
+  if (!TTI.shouldEmitMemberFunctions(def)) {
+    // skip the functions of library classes: they are not emitted and
+    // would pull their whole signatures into the type table.
+    return symbolsNode;
+  }
   for (auto &&method : def->methods()) {
     auto idNode = makeIdNodeForCXXMethodDecl(TTI, method);
     xmlAddChild(symbolsNode, idNode);
@@ -274,15 +505,18 @@ TypeTableInfo::registerType(QualType T, xmlNodePtr *retNode, xmlNodePtr) {
 
   if (!T.isCanonical()) {
     registerType(T.getCanonicalType(), retNode, nullptr);
-    mapFromQualTypeToName[T] = mapFromQualTypeToName[T.getCanonicalType()];
+    const auto nameId = findRecord(T.getCanonicalType())->nameId;
+    getOrCreateRecord(T).nameId = nameId;
     return;
   }
 
-  if (mapFromQualTypeToName.find(T) != mapFromQualTypeToName.end()) {
-    if (retNode != nullptr) {
-      *retNode = mapFromQualTypeToXmlNodePtr[T];
+  if (const auto record = findRecord(T)) {
+    if (record->nameId != noName) {
+      if (retNode != nullptr) {
+        *retNode = record->node;
+      }
+      return;
     }
-    return;
   }
 
   if (T.isConstQualified()) {
@@ -329,7 +563,7 @@ TypeTableInfo::registerType(QualType T, xmlNodePtr *retNode, xmlNodePtr) {
           *I = '_';
         }
       }
-      mapFromQualTypeToName[T] = rawname;
+      setTypeName(T, rawname);
       break;
     }
 
@@ -569,8 +803,12 @@ TypeTableInfo::registerType(QualType T, xmlNodePtr *retNode, xmlNodePtr) {
   if (retNode != nullptr) {
     *retNode = Node;
   }
-  mapFromNameToQualType[rawname] = T;
-  mapFromQualTypeToXmlNodePtr[T] = Node;
+  auto &record = getOrCreateRecord(T);
+  if (record.nameId == noName) {
+    // T is of a type class not handled above
+    setTypeName(T, rawname);
+  }
+  record.node = Node;
 }
 
 void
@@ -578,64 +816,26 @@ TypeTableInfo::registerLabelType(void) {
   useLabelType = true;
 }
 
-std::string
+const std::string &
 TypeTableInfo::getTypeName(QualType T) {
+  static const std::string nullTypeName("nullType");
   if (T.isNull()) {
-    return "nullType";
+    return nullTypeName;
   };
 
-  const auto iter = mapFromQualTypeToName.find(T);
-  std::string name;
-  if (iter != mapFromQualTypeToName.end()) {
-    name = iter->second;
-  } else {
+  auto record = findRecord(T);
+  if (!record || record->nameId == noName) {
     registerType(T, nullptr, nullptr);
-    name = mapFromQualTypeToName[T];
+    record = findRecord(T);
   }
-
-  if (!map_is_already_set) {
-    typenamemap["unsigned_int"] = "unsigned";
-  }
-  if (!OptTypeNameMap.empty()) {
-    if (!map_is_already_set) {
-      std::cerr << "use " << OptTypeNameMap << " as a typenamemap file"
-                << std::endl;
-      mapfile.open(OptTypeNameMap);
-      if (mapfile.fail()) {
-        std::cerr << OptTypeNameMap << ": cannot open" << std::endl;
-        exit(1);
-      }
-      map_is_already_set = true;
-
-      typenamemap.clear();
-      std::string line;
-      while (std::getline(mapfile, line)) {
-        std::istringstream iss(line);
-        std::string lhs, rhs;
-        iss >> lhs >> rhs;
-        if (!iss) {
-          std::cerr << OptTypeNameMap << ": read error" << std::endl;
-          exit(1);
-        }
-        typenamemap[lhs] = rhs;
-        // std::cerr << "typenamemap: " << lhs << "->" << rhs << std::endl;
-      }
-    }
-    std::string rhs = typenamemap[name];
-    return !rhs.empty() ? rhs : name;
-  }
-
-  map_is_already_set = true;
-  return name;
+  return typeNames[record->nameId];
 }
 
 std::string
 TypeTableInfo::getTypeNameForLabel(void) {
-  if (!typenamemap["Label"].empty()) {
-    return typenamemap["Label"];
-  } else {
-    return "Label";
-  }
+  const auto &typenamemap = getTypeNameMap();
+  const auto iter = typenamemap.find("Label");
+  return iter != typenamemap.end() ? iter->second : "Label";
 }
 
 std::vector<BaseClass>
@@ -653,13 +853,18 @@ TypeTableInfo::hasBaseClass(clang::QualType type) {
   return !(inheritanceinfo->getInheritance(type).empty());
 }
 
+bool
+TypeTableInfo::shouldEmitMemberFunctions(const clang::RecordDecl *RD) {
+  return !declfilter || declfilter->shouldEmitMemberFunctions(RD);
+}
+
 void
 TypeTableInfo::setNormalizability(clang::QualType T, bool b) {
-  normalizability[T] = b;
+  getOrCreateRecord(T).isNormalizable = b;
 }
 
 bool TypeTableInfo::isNormalizable(clang::QualType) {
-  // return normalizability[T];
+  // return findRecord(T) && findRecord(T)->isNormalizable;
   return false;
 }
 
@@ -670,36 +875,36 @@ TypeTableInfo::pushTypeTableStack(xmlNodePtr typeTableNode) {
 
 void
 TypeTableInfo::popTypeTableStack() {
+  PhaseTimer timer("type-table-flush");
   assert(!typeTableStack.empty());
   const auto typeTableNode = std::get<0>(typeTableStack.top());
   const auto latestTypes = std::get<1>(typeTableStack.top());
   for (auto T : latestTypes) {
-    mapFromQualTypeToName.erase(T);
-
-    if (TypeElements.find(T) != TypeElements.end()) {
+    const auto record = findRecord(T);
+    if (record && record->isPending) {
       /*
        * If data type definition element exists,
        * add it to current typeTable.
        * Fundamental types do not have data type definition elements.
        * (Example: `int`)
        */
-      xmlAddChild(typeTableNode, TypeElements[T]);
-      TypeElements.erase(T);
+      xmlAddChild(typeTableNode, record->node);
+      record->isPending = false;
     }
-
-    const auto name = mapFromQualTypeToName[T];
-    mapFromNameToQualType.erase(name);
+    mapFromQualTypeToRecord.erase(T.getAsOpaquePtr());
   }
   typeTableStack.pop();
 }
 
 void
 TypeTableInfo::dump() {
-  for (auto &pair : mapFromNameToQualType) {
-    auto name = pair.first;
-    auto type = pair.second;
-    std::cerr << name << ": " << type.getAsString() << std::endl;
-  }
+  mapFromQualTypeToRecord.forEach([this](const void *, unsigned index) {
+    const auto &record = typeRecords[index];
+    if (record.type.isCanonical() && record.nameId != noName) {
+      std::cerr << typeNames[record.nameId] << ": "
+                << record.type.getAsString() << std::endl;
+    }
+  });
 }
 
 ///
@@ -2,17 +2,37 @@
 #define TYPETABLEVISITOR_H
 
 #include "InheritanceInfo.h"
+#include <deque>
 #include <stack>
 #include <tuple>
-#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class DeclFilter;
 
 class TypeTableInfo {
+  /*!
+   * \brief What TypeTableInfo knows about one clang::QualType.
+   *
+   * A non-canonical type shares the name of its canonical type.
+   */
+  struct TypeRecord {
+    clang::QualType type;
+    unsigned nameId; // index into typeNames, or noName
+    xmlNodePtr node; // the data type definition element (may be null)
+    bool isPending; // node is to be added to the current typeTable
+    bool isNormalizable;
+  };
+  static const unsigned noName = ~0u;
+
   clang::MangleContext *mangleContext;
-  std::unordered_map<std::string, clang::QualType> mapFromNameToQualType;
-  std::unordered_map<clang::QualType, std::string> mapFromQualTypeToName;
-  std::unordered_map<clang::QualType, xmlNodePtr> mapFromQualTypeToXmlNodePtr;
+  // index into typeRecords, keyed by QualType::getAsOpaquePtr()
+  OpaquePtrMap<unsigned> mapFromQualTypeToRecord;
+  std::vector<TypeRecord> typeRecords;
+  // names after -typenamemap substitution; deque keeps references valid
+  std::deque<std::string> typeNames;
   InheritanceInfo *inheritanceinfo;
-  std::unordered_map<clang::QualType, bool> normalizability;
+  DeclFilter *declfilter;
   std::stack<std::tuple<xmlNodePtr, std::vector<clang::QualType>>>
       typeTableStack;
 
@@ -26,10 +46,16 @@ class TypeTableInfo {
   int seqForClassType;
   int seqForOtherType;
 
-  std::unordered_map<clang::QualType, xmlNodePtr> TypeElements;
-
   bool useLabelType;
+  std::unordered_set<std::string> stableNames;
+  bool usePlaceholderNames;
+  // what each placeholder stands for (see ParallelTraversal.h)
+  std::vector<std::pair<const void *, bool>> placeholderNames;
 
+  TypeRecord *findRecord(clang::QualType T);
+  TypeRecord &getOrCreateRecord(clang::QualType T);
+  const std::string &setTypeName(clang::QualType T, const std::string &name);
+  std::string makeTypeName(clang::QualType T, const char *prefix, int &seq);
   xmlNodePtr createNode(
       clang::QualType T, const char *fieldname, xmlNodePtr traversingNode);
   std::string registerBasicType(clang::QualType T); // "B*"
@@ -48,17 +74,54 @@ public:
   TypeTableInfo &operator=(const TypeTableInfo &) = delete;
   TypeTableInfo &operator=(const TypeTableInfo &&) = delete;
 
-  explicit TypeTableInfo(
-      clang::MangleContext *MC, InheritanceInfo *II); // default constructor
+  explicit TypeTableInfo(clang::MangleContext *MC,
+      InheritanceInfo *II,
+      DeclFilter *DF = nullptr); // default constructor
 
   void registerType(
       clang::QualType T, xmlNodePtr *retNode, xmlNodePtr traversingNode);
   void registerLabelType(void);
-  std::string getTypeName(clang::QualType T);
+  const std::string &getTypeName(clang::QualType T);
   std::string getTypeNameForLabel(void);
+  /*! \brief Returns the file given by `-typenamemap`, or "". */
+  static const std::string &getTypeNameMapFile();
+  /*!
+   * \brief Returns `prefix` followed by a hash of `spelling`, made
+   * unique among the names returned so far (for -reproducible).
+   */
+  std::string makeStableName(
+      const std::string &prefix, const std::string &spelling);
+  /*!
+   * \brief Appends to `spelling` the normalized presumed location of
+   * each unnamed or local tag `T` refers to.
+   *
+   * Such tags print alike, so without their locations makeStableName
+   * would tell them apart by the order of registration.
+   */
+  void appendTagLocations(clang::QualType T, std::string &spelling) const;
+  /*!
+   * \brief Names the types and NNS registered from now on with
+   * placeholders, in a worker of `-traversal-jobs`.
+   */
+  void enablePlaceholderNames();
+  bool
+  isUsingPlaceholderNames() const {
+    return usePlaceholderNames;
+  }
+  /*!
+   * \brief Returns a new placeholder standing for the type (`isNns` is
+   * false) or the NNS `key`.
+   */
+  std::string makePlaceholderName(const void *key, bool isNns);
+  /*! \brief What each placeholder stands for, by index. */
+  const std::vector<std::pair<const void *, bool>> &
+  getPlaceholderNames() const {
+    return placeholderNames;
+  }
   std::vector<BaseClass> getBaseClasses(clang::QualType type);
   void addInheritance(clang::QualType derived, BaseClass base);
   bool hasBaseClass(clang::QualType type);
+  bool shouldEmitMemberFunctions(const clang::RecordDecl *RD);
   void setNormalizability(clang::QualType, bool);
   bool isNormalizable(clang::QualType);
   void pushTypeTableStack(xmlNodePtr);
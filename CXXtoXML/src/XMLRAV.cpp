@@ -1,4 +1,5 @@
 #include "XMLRAV.h"
+#include "DeclFilter.h"
 
 #include "clang/Driver/Options.h"
 #include "clang/AST/RecursiveASTVisitor.h"
@@ -33,6 +34,11 @@ public:
     return false;
   }
 
+  bool
+  shouldVisitTemplateInstantiations() const {
+    return DeclFilter::shouldVisitTemplateInstantiations();
+  }
+
 #define DISPATCHER(NAME, TYPE)                                                \
   bool Traverse##NAME(TYPE S) {                                               \
     const char *VN = otherside->getVisitorName();                             \
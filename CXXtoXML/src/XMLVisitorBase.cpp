@@ -1,4 +1,6 @@
 #include "XMLVisitorBase.h"
+#include "DeclFilter.h"
+#include "FileTableInfo.h"
 #include "clang/Driver/Options.h"
 #include "clang/Lex/Lexer.h"
 
@@ -25,17 +27,32 @@ OptEmitSourceRange("range", cl::desc("emit 'range'"),
                    cl::cat(CXX2XMLCategory));
 #endif
 
+cl::opt<bool> OptCompactOutput("compact-output",
+    cl::desc("omit indentation, comments and false boolean attributes"),
+    cl::cat(CXX2XMLCategory));
+
+cl::opt<bool> OptReproducible("reproducible",
+    cl::desc("emit no timestamp, normalized file names and type names "
+             "derived from the types instead of sequence numbers"),
+    cl::cat(CXX2XMLCategory));
+
 // implementation of XMLVisitorBaseImpl
 
 XMLVisitorBaseImpl::XMLVisitorBaseImpl(MangleContext *MC,
     xmlNodePtr CurNode,
     TypeTableInfo *TTI,
-    NnsTableInfo *NTI)
+    NnsTableInfo *NTI,
+    DeclFilter *DF,
+    FileTableInfo *FTI,
+    CommentAttacher *CA)
     : XMLRAVpool(this),
       mangleContext(MC),
       curNode(CurNode),
       typetableinfo(TTI),
-      nnstableinfo(NTI) {
+      nnstableinfo(NTI),
+      declfilter(DF),
+      filetableinfo(FTI),
+      commentattacher(CA) {
 }
 
 xmlNodePtr
@@ -65,11 +82,18 @@ XMLVisitorBaseImpl::newProp(const char *Name, const char *Val, xmlNodePtr N) {
 
 void
 XMLVisitorBaseImpl::newBoolProp(const char *Name, bool Val, xmlNodePtr N) {
+  if (OptCompactOutput && !Val) {
+    // the readers treat a missing boolean attribute as false.
+    return;
+  }
   newProp(Name, Val ? "1" : "0", N);
 }
 
 void
 XMLVisitorBaseImpl::newComment(const xmlChar *str, xmlNodePtr N) {
+  if (OptCompactOutput) {
+    return;
+  }
   if (!N)
     N = curNode;
   if (const auto pName = getVisitorName()) {
@@ -95,6 +119,10 @@ void
 XMLVisitorBaseImpl::setLocation(SourceLocation Loc, xmlNodePtr N) {
   if (!N)
     N = curNode;
+  if (filetableinfo) {
+    filetableinfo->setLocation(N, Loc);
+    return;
+  }
   FullSourceLoc FLoc = mangleContext->getASTContext().getFullLoc(Loc);
   if (FLoc.isValid()) {
     PresumedLoc PLoc = FLoc.getManager().getPresumedLoc(FLoc);
@@ -119,6 +147,28 @@ XMLVisitorBaseImpl::setLocation(SourceLocation Loc, xmlNodePtr N) {
   }
 }
 
+bool
+XMLVisitorBaseImpl::getLineAndColumn(
+    SourceLocation Loc, unsigned &line, unsigned &column) {
+  if (filetableinfo) {
+    FileTableInfo::ResolvedLoc RLoc;
+    if (!filetableinfo->resolve(Loc, RLoc)) {
+      return false;
+    }
+    line = RLoc.line;
+    column = RLoc.column;
+    return true;
+  }
+  FullSourceLoc FLoc = mangleContext->getASTContext().getFullLoc(Loc);
+  if (!FLoc.isValid()) {
+    return false;
+  }
+  PresumedLoc PLoc = FLoc.getManager().getPresumedLoc(FLoc);
+  line = PLoc.getLine();
+  column = PLoc.getColumn();
+  return true;
+}
+
 std::string
 XMLVisitorBaseImpl::contentBySource(
     SourceLocation LocStart, SourceLocation LocEnd) {
@@ -139,6 +189,11 @@ XMLVisitorBaseImpl::contentBySource(
   }
 }
 
+bool
+XMLVisitorBaseImpl::isExcluded(Decl *D) const {
+  return D && declfilter && declfilter->isExcluded(D);
+}
+
 ///
 /// Local Variables:
 /// indent-tabs-mode: nil
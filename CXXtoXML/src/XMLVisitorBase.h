@@ -2,6 +2,7 @@
 #define XMLVISITORBASE_H
 
 #include "XMLRAV.h"
+#include "ConversionStats.h"
 #include "llvm/ADT/SmallVector.h"
 #include "clang/AST/Mangle.h"
 
@@ -11,6 +12,17 @@
 
 class TypeTableInfo;
 class NnsTableInfo;
+class DeclFilter;
+class FileTableInfo;
+class CommentAttacher;
+
+// -compact-output: no indentation, no comments and
+// no boolean attributes of the default value (false).
+extern llvm::cl::opt<bool> OptCompactOutput;
+
+// -reproducible: the same input yields the same bytes
+// (no timestamp, normalized file names, hash-based type names).
+extern llvm::cl::opt<bool> OptReproducible;
 
 // some members & methods of XMLVisitorBase do not need the info
 // of deriving type <Derived>:
@@ -22,6 +34,9 @@ protected:
   xmlNodePtr curNode; // a candidate of the new chlid.
   TypeTableInfo *typetableinfo;
   NnsTableInfo *nnstableinfo;
+  DeclFilter *declfilter;
+  FileTableInfo *filetableinfo;
+  CommentAttacher *commentattacher;
 
 public:
   XMLVisitorBaseImpl() = delete;
@@ -33,7 +48,10 @@ public:
   explicit XMLVisitorBaseImpl(clang::MangleContext *MC,
       xmlNodePtr CurNode,
       TypeTableInfo *TTI,
-      NnsTableInfo *NTI);
+      NnsTableInfo *NTI,
+      DeclFilter *DF,
+      FileTableInfo *FTI,
+      CommentAttacher *CA);
 
   xmlNodePtr addChild(const char *Name, const char *Content = nullptr);
   void newChild(const char *Name, const char *Content = nullptr);
@@ -44,8 +62,22 @@ public:
   void newComment(const char *str, xmlNodePtr RN = nullptr);
   void newComment(const std::string &str, xmlNodePtr RN = nullptr);
   void setLocation(clang::SourceLocation Loc, xmlNodePtr N = nullptr);
+  bool getLineAndColumn(
+      clang::SourceLocation Loc, unsigned &line, unsigned &column);
   std::string contentBySource(
       clang::SourceLocation LocStart, clang::SourceLocation LocEnd);
+
+  /*!
+   * \brief Returns true if `D` is left to another worker of
+   * `-traversal-jobs` or `-pipeline-jobs`; such a node is not counted
+   * for `-stats`, so the counts are those of a sequential run.
+   */
+  bool isExcluded(clang::Decl *D) const;
+  template <typename T>
+  bool
+  isExcluded(const T &) const {
+    return false;
+  }
 };
 
 // Main class: XMLVisitorBase<Derived>
@@ -66,17 +98,28 @@ public:
       xmlNodePtr Parent,
       const char *ChildName,
       TypeTableInfo *TTI = nullptr,
-      NnsTableInfo *NTI = nullptr)
+      NnsTableInfo *NTI = nullptr,
+      DeclFilter *DF = nullptr,
+      FileTableInfo *FTI = nullptr,
+      CommentAttacher *CA = nullptr)
       : XMLVisitorBaseImpl(MC,
             (ChildName ? xmlNewTextChild(
                              Parent, nullptr, BAD_CAST ChildName, nullptr)
                        : Parent),
             TTI,
-            NTI),
+            NTI,
+            DF,
+            FTI,
+            CA),
         optContext(){};
   explicit XMLVisitorBase(XMLVisitorBase *p)
-      : XMLVisitorBaseImpl(
-            p->mangleContext, p->curNode, p->typetableinfo, p->nnstableinfo),
+      : XMLVisitorBaseImpl(p->mangleContext,
+            p->curNode,
+            p->typetableinfo,
+            p->nnstableinfo,
+            p->declfilter,
+            p->filetableinfo,
+            p->commentattacher),
         optContext(p->optContext){};
 
   Derived &
@@ -94,17 +137,18 @@ public:                                                                       \
     return V.TraverseMe##NAME(S);                                             \
   }                                                                           \
   bool TraverseMe##NAME(TYPE S) {                                             \
+    if (ConversionStats::isEnabled() && !isExcluded(S)) {                     \
+      ConversionStats::countNode(#NAME, NameFor##NAME(S));                    \
+    }                                                                         \
     std::string comment("Traverse" #NAME ":");                                \
     llvm::raw_string_ostream OS(comment);                                     \
-    OS << NameFor##NAME(S);                                                   \
     clang::SourceLocation SL;                                                 \
-    if (SourceLocFor##NAME(S, SL)) {                                          \
-      clang::FullSourceLoc FL;                                                \
-      FL = mangleContext->getASTContext().getFullLoc(SL);                     \
-      if (FL.isValid()) {                                                     \
-        clang::PresumedLoc PL;                                                \
-        PL = FL.getManager().getPresumedLoc(FL);                              \
-        OS << ":" << PL.getLine() << ":" << PL.getColumn();                   \
+    if ((getDerived().FullTrace() || getVisitorName())                        \
+        && SourceLocFor##NAME(S, SL)) {                                       \
+      OS << NameFor##NAME(S);                                                 \
+      unsigned line, column;                                                  \
+      if (getLineAndColumn(SL, line, column)) {                               \
+        OS << ":" << line << ":" << column;                                   \
       }                                                                       \
       if (getDerived().FullTrace()) {                                         \
         newChild(OS.str().c_str());                                           \
@@ -377,6 +377,14 @@
     </intConstant>
   </xsl:template>
 
+  <!-- packed initializer list of integer literals -->
+  <xsl:template match="intConstantList">
+    <intConstantList>
+      <xsl:apply-templates select="@*" />
+      <xsl:value-of select="." />
+    </intConstantList>
+  </xsl:template>
+
   <xsl:template match="clangStmt[@class='FloatingLiteral']">
     <floatConstant>
       <xsl:apply-templates select="@*" />
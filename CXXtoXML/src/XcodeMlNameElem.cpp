@@ -39,6 +39,9 @@ makeIdNode(TypeTableInfo &TTI, const ValueDecl *VD) {
 
 void
 xmlNewBoolProp(xmlNodePtr node, const std::string &name, bool value) {
+  if (OptCompactOutput && !value) {
+    return;
+  }
   xmlNewProp(node, BAD_CAST(name.c_str()), BAD_CAST(value ? "true" : "false"));
 }
 
@@ -0,0 +1,158 @@
+/*
+ * Microbenchmark of the QualType tables of TypeTableInfo: OpaquePtrMap
+ * with one dense record per type against the former layout, four
+ * std::unordered_map keyed by the raw opaque pointer.
+ *
+ * The keys imitate a type-heavy TU: types allocated 16-byte aligned
+ * from a bump allocator, with const/volatile/restrict in the low bits.
+ * Every lookup resolves the name and the node of a type, which is what
+ * getTypeName and registerType do.
+ *
+ * Usage: OpaquePtrMapBench [number of types] [number of lookups]
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "OpaquePtrMap.h"
+
+namespace {
+
+/*!
+ * \brief The former std::hash<clang::QualType>: the opaque pointer as is.
+ */
+struct RawPtrHash {
+  std::size_t
+  operator()(const void *p) const {
+    return reinterpret_cast<std::uintptr_t>(p);
+  }
+};
+
+std::vector<const void *>
+makeKeys(size_t count) {
+  std::mt19937 engine(20170101);
+  std::uniform_int_distribution<int> typeSize(1, 6); // in 16 bytes
+  std::uniform_int_distribution<int> quals(0, 15);
+  std::vector<const void *> keys;
+  keys.reserve(count);
+  std::uintptr_t addr = 0x7f0000100000;
+  for (size_t i = 0; i < count; ++i) {
+    const int q = quals(engine);
+    // mostly unqualified; sometimes a qualified variant of the last type
+    const bool qualified = q < 3 && !keys.empty();
+    if (!qualified) {
+      addr += 16 * typeSize(engine);
+    }
+    const std::uintptr_t qualifiers = qualified ? q + 1 : 0;
+    keys.push_back(reinterpret_cast<const void *>(addr + qualifiers));
+  }
+  return keys;
+}
+
+/*!
+ * \brief Makes `count` indices into `keys`, skewed towards few hot types
+ * (`int`, `char *`, ...) as in real code.
+ */
+std::vector<size_t>
+makeQueries(size_t keyCount, size_t count) {
+  std::mt19937 engine(20170102);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::vector<size_t> queries;
+  queries.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    const double u = uniform(engine);
+    queries.push_back(static_cast<size_t>(u * u * u * keyCount));
+  }
+  return queries;
+}
+
+struct Record {
+  unsigned nameId;
+  void *node;
+  bool isPending;
+};
+
+template <typename F>
+double
+measure(F f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+} // namespace
+
+int
+main(int argc, char **argv) {
+  const size_t typeCount =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+  const size_t lookupCount =
+      argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000000;
+  const auto keys = makeKeys(typeCount);
+  const auto queries = makeQueries(keys.size(), lookupCount);
+  size_t checksumNew = 0, checksumOld = 0;
+
+  OpaquePtrMap<unsigned> index;
+  std::vector<Record> records;
+  std::vector<std::string> names;
+  const double insertNew = measure([&]() {
+    for (auto key : keys) {
+      const auto result = index.insert(key, records.size());
+      if (result.second) {
+        names.push_back("Type" + std::to_string(names.size()));
+        records.push_back(
+            Record{static_cast<unsigned>(names.size() - 1), nullptr, true});
+      }
+    }
+  });
+  const double lookupNew = measure([&]() {
+    for (auto q : queries) {
+      const auto &record = records[*index.find(keys[q])];
+      checksumNew += names[record.nameId].size() + record.isPending;
+    }
+  });
+
+  std::unordered_map<const void *, std::string, RawPtrHash> toName;
+  std::unordered_map<const void *, void *, RawPtrHash> toNode;
+  std::unordered_map<const void *, void *, RawPtrHash> elements;
+  std::unordered_map<std::string, const void *> toType;
+  const double insertOld = measure([&]() {
+    for (auto key : keys) {
+      if (toName.find(key) == toName.end()) {
+        const auto name = "Type" + std::to_string(toName.size());
+        toName[key] = name;
+        elements[key] = nullptr;
+        toType[name] = key;
+        toNode[key] = nullptr;
+      }
+    }
+  });
+  const double lookupOld = measure([&]() {
+    for (auto q : queries) {
+      const auto key = keys[q];
+      checksumOld += toName.find(key)->second.size()
+          + (elements.find(key) != elements.end());
+    }
+  });
+
+  if (checksumNew != checksumOld) {
+    std::cerr << "OpaquePtrMapBench: results differ" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << typeCount << " types, " << lookupCount << " lookups"
+            << std::endl
+            << "register: dense " << insertNew * 1e9 / typeCount
+            << " ns/type, unordered_map " << insertOld * 1e9 / typeCount
+            << " ns/type" << std::endl
+            << "lookup: dense " << lookupNew * 1e9 / lookupCount
+            << " ns, unordered_map " << lookupOld * 1e9 / lookupCount
+            << " ns" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+/*
+ * Microbenchmark of escapeStringLiteral (used for StringLiteral in
+ * DeclarationsVisitor) against the byte-at-a-time reference.
+ *
+ * Usage: StringEscapeBench [size in bytes] [repetitions]
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "StringEscape.h"
+
+namespace {
+
+/*!
+ * \brief Makes `size` bytes of text in which about one byte in
+ * `period` needs escaping.
+ */
+std::string
+makeInput(size_t size, int period) {
+  std::mt19937 engine(20170101);
+  std::uniform_int_distribution<int> printable('a', 'z');
+  std::string s;
+  s.reserve(size);
+  for (size_t i = 0; i < size; ++i) {
+    s += (i % period == period - 1) ? '\n' : printable(engine);
+  }
+  return s;
+}
+
+template <typename F>
+double
+measure(F escape, const std::string &input, int repetitions, size_t &len) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repetitions; ++i) {
+    std::string out;
+    escape(input.data(), input.size(), out);
+    len = out.size();
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+} // namespace
+
+int
+main(int argc, char **argv) {
+  const size_t size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 20;
+  const int repetitions = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  for (const int period : {1000000, 80, 8}) {
+    const auto input = makeInput(size, period);
+    size_t fastLen = 0, scalarLen = 0;
+    const double fast =
+        measure(escapeStringLiteral, input, repetitions, fastLen);
+    const double scalar =
+        measure(escapeStringLiteralScalar, input, repetitions, scalarLen);
+    if (fastLen != scalarLen) {
+      std::cerr << "StringEscapeBench: results differ" << std::endl;
+      return EXIT_FAILURE;
+    }
+    const double megabytes = static_cast<double>(size) * repetitions / 1e6;
+    std::cout << "1 escape per " << period << " bytes: "
+              << "fast " << megabytes / fast << " MB/s, "
+              << "scalar " << megabytes / scalar << " MB/s" << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
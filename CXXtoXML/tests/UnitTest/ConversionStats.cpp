@@ -0,0 +1,56 @@
+#define BOOST_TEST_MODULE ConversionStats
+#include <boost/test/included/unit_test.hpp>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <sstream>
+#include <string>
+
+#include "ConversionStats.h"
+
+BOOST_AUTO_TEST_SUITE(conversion_stats)
+
+BOOST_AUTO_TEST_CASE(node_test) {
+  BOOST_TEST_CHECKPOINT("nodes are counted by category and kind");
+  ConversionStats::countNode("Stmt", "IntegerLiteral");
+  ConversionStats::countNode("Decl", "Var");
+  ConversionStats::countNode("Decl", "Var");
+  ConversionStats::addNodeCounts({{"Decl:Var", 3}, {"Decl:Field", 1}});
+  BOOST_CHECK(ConversionStats::takeNodeCounts()
+      == (NodeCounts{
+             {"Decl:Field", 1}, {"Decl:Var", 5}, {"Stmt:IntegerLiteral", 1}}));
+  BOOST_CHECK(ConversionStats::takeNodeCounts().empty());
+}
+
+BOOST_AUTO_TEST_CASE(print_test) {
+  BOOST_TEST_CHECKPOINT("the document and the nodes are summarized");
+  const std::string xml = "<Program source=\"a.cpp\"><clangAST>"
+                          "<clangDecl class=\"TranslationUnit\">"
+                          "<xcodemlTypeTable>"
+                          "<pointerType type=\"Pointer0\" ref=\"int\"/>"
+                          "<pointerType type=\"Pointer1\" ref=\"Pointer0\"/>"
+                          "<classType type=\"Class0\"/>"
+                          "</xcodemlTypeTable>"
+                          "<xcodemlNnsTable><namespaceNNS nns=\"NNS0\"/>"
+                          "</xcodemlNnsTable><!-- x -->"
+                          "</clangDecl></clangAST></Program>";
+  xmlDocPtr doc = xmlReadMemory(xml.data(), xml.size(), "", nullptr, 0);
+  ConversionStats::countNode("Decl", "TranslationUnit");
+  ConversionStats::countNode("Stmt", "NullStmt");
+  std::stringstream ss;
+  ConversionStats::print(ss, "dir/\"a\".cpp", doc);
+  BOOST_CHECK(ss.str()
+      == "{\"source\": \"dir/\\\"a\\\".cpp\", "
+         "\"astNodes\": {\"Decl\": {\"TranslationUnit\": 1}, "
+         "\"Stmt\": {\"NullStmt\": 1}}, "
+         "\"xmlElements\": 9, \"xmlAttributes\": 8, "
+         "\"typeTable\": {\"classType\": 1, \"pointerType\": 2}, "
+         "\"nnsTable\": 1}\n");
+
+  BOOST_TEST_CHECKPOINT("the nodes are counted again for the next unit");
+  ss.str("");
+  ConversionStats::print(ss, "b.cpp", doc);
+  BOOST_CHECK(ss.str().find("\"astNodes\": {}, ") != std::string::npos);
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,167 @@
+#define BOOST_TEST_MODULE HeaderFragments
+#include <boost/test/included/unit_test.hpp>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+#include "HeaderFragments.h"
+
+namespace {
+
+const char program[] = "<Program source=\"a.cpp\">"
+                       "<clangAST>"
+                       "<clangDecl class=\"TranslationUnit\">"
+                       "<xcodemlTypeTable>"
+                       "<pointerType type=\"Pointer_p\" ref=\"Record_s\"/>"
+                       "<classType type=\"Record_s\"/>"
+                       "<classType type=\"Record_m\"/>"
+                       "</xcodemlTypeTable>"
+                       "<xcodemlNnsTable>"
+                       "<classNNS type=\"Record_s\" nns=\"NNS_s\"/>"
+                       "</xcodemlNnsTable>"
+                       "<clangDecl class=\"Typedef\"/>"
+                       "<clangDecl class=\"Var\" file=\"inc/h.h\""
+                       " xcodemlType=\"Pointer_p\"/>"
+                       "<clangDecl class=\"Var\" file=\"inc/h.h\">"
+                       "<name nns=\"NNS_s\">v</name>"
+                       "</clangDecl>"
+                       "<clangDecl class=\"Var\" file=\"a.cpp\""
+                       " xcodemlType=\"Record_m\"/>"
+                       "<clangDecl class=\"Var\" file=\"inc/h.h\""
+                       " xcodemlType=\"Pointer_p\"/>"
+                       "</clangDecl>"
+                       "</clangAST>"
+                       "</Program>";
+
+struct TempDir {
+  TempDir() {
+    char name[] = "/tmp/HeaderFragmentsXXXXXX";
+    path = mkdtemp(name);
+  }
+  ~TempDir() {
+    const auto command = "rm -rf " + path;
+    BOOST_CHECK(std::system(command.c_str()) == 0);
+  }
+  std::string path;
+};
+
+xmlDocPtr
+parse(const std::string &xml) {
+  return xmlReadMemory(xml.data(), xml.size(), "", nullptr, 0);
+}
+
+std::string
+dump(xmlNodePtr node) {
+  xmlBufferPtr buffer = xmlBufferCreate();
+  xmlNodeDump(buffer, node->doc, node, 0, 0);
+  const std::string s(reinterpret_cast<const char *>(buffer->content));
+  xmlBufferFree(buffer);
+  return s;
+}
+
+std::string
+readFile(const std::string &path) {
+  std::ifstream in(path);
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+xmlNodePtr
+getTranslationUnit(xmlDocPtr doc) {
+  return xmlDocGetRootElement(doc)->children->children;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(header_fragments)
+
+BOOST_AUTO_TEST_CASE(split_test) {
+  BOOST_TEST_CHECKPOINT("declarations from headers become fragments");
+  TempDir dir;
+  HeaderFragments fragments(dir.path, 0);
+  xmlDocPtr doc = parse(program);
+  BOOST_REQUIRE(fragments.split(xmlDocGetRootElement(doc), "a.cpp"));
+  BOOST_REQUIRE(fragments.getFiles().size() == 3);
+  BOOST_CHECK(fragments.getWrittenCount() == 3);
+
+  std::string refs;
+  for (auto child = getTranslationUnit(doc)->children; child;
+       child = child->next) {
+    refs += reinterpret_cast<const char *>(child->name);
+    refs += " ";
+  }
+  BOOST_CHECK(refs
+      == "xcodemlTypeTable xcodemlNnsTable fragmentRef fragmentRef "
+         "clangDecl fragmentRef ");
+  // the entries some fragment holds are left out
+  const auto tu = dump(getTranslationUnit(doc));
+  BOOST_CHECK(tu.find("Record_m") != std::string::npos);
+  BOOST_CHECK(tu.find("type=\"Record_s\"") == std::string::npos);
+  BOOST_CHECK(tu.find("NNS_s") == std::string::npos);
+  BOOST_CHECK(tu.find("header=\"inc/h.h\"") != std::string::npos);
+
+  const auto header = readFile(fragments.getFiles()[1]);
+  BOOST_CHECK(fragments.getFiles()[1].find("/h.h-") != std::string::npos);
+  BOOST_CHECK(header.find("<Program source=\"inc/h.h\"") != std::string::npos);
+  BOOST_CHECK(header.find("Pointer_p") != std::string::npos);
+  BOOST_CHECK(header.find("type=\"Record_s\"/>") != std::string::npos);
+  BOOST_CHECK(header.find("nns=\"NNS_s\"/>") != std::string::npos);
+  BOOST_CHECK(header.find("Record_m") == std::string::npos);
+  const auto builtin = readFile(fragments.getFiles()[0]);
+  BOOST_CHECK(builtin.find("Typedef") != std::string::npos);
+  BOOST_CHECK(builtin.find("Pointer_p") == std::string::npos);
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_CASE(reuse_test) {
+  BOOST_TEST_CHECKPOINT("identical fragments are written once");
+  TempDir dir;
+  HeaderFragments first(dir.path, 0);
+  xmlDocPtr doc1 = parse(program);
+  BOOST_REQUIRE(first.split(xmlDocGetRootElement(doc1), "a.cpp"));
+
+  HeaderFragments second(dir.path, 0);
+  xmlDocPtr doc2 = parse(program);
+  BOOST_REQUIRE(second.split(xmlDocGetRootElement(doc2), "a.cpp"));
+  BOOST_CHECK(second.getWrittenCount() == 0);
+  BOOST_CHECK(first.getFiles() == second.getFiles());
+  BOOST_CHECK(dump(getTranslationUnit(doc1))
+      == dump(getTranslationUnit(doc2)));
+
+  // another header content gives another fragment
+  std::string changed(program);
+  changed.replace(changed.find(">v<"), 3, ">w<");
+  HeaderFragments third(dir.path, 0);
+  xmlDocPtr doc3 = parse(changed);
+  BOOST_REQUIRE(third.split(xmlDocGetRootElement(doc3), "a.cpp"));
+  BOOST_CHECK(third.getWrittenCount() == 1);
+  BOOST_CHECK(third.getFiles()[1] != first.getFiles()[1]);
+  xmlFreeDoc(doc1);
+  xmlFreeDoc(doc2);
+  xmlFreeDoc(doc3);
+}
+
+BOOST_AUTO_TEST_CASE(main_file_only_test) {
+  BOOST_TEST_CHECKPOINT("a translation unit without headers is kept");
+  TempDir dir;
+  HeaderFragments fragments(dir.path, 0);
+  xmlDocPtr doc = parse("<Program><clangAST>"
+                        "<clangDecl class=\"TranslationUnit\">"
+                        "<xcodemlTypeTable><classType type=\"Record_m\"/>"
+                        "</xcodemlTypeTable>"
+                        "<clangDecl class=\"Var\" file=\"a.cpp\""
+                        " xcodemlType=\"Record_m\"/>"
+                        "</clangDecl></clangAST></Program>");
+  const auto before = dump(xmlDocGetRootElement(doc));
+  BOOST_REQUIRE(fragments.split(xmlDocGetRootElement(doc), "a.cpp"));
+  BOOST_CHECK(fragments.getFiles().empty());
+  BOOST_CHECK(dump(xmlDocGetRootElement(doc)) == before);
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
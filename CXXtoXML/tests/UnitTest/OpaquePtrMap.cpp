@@ -0,0 +1,81 @@
+#define BOOST_TEST_MODULE OpaquePtrMap
+#include <boost/test/included/unit_test.hpp>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+
+#include "OpaquePtrMap.h"
+
+namespace {
+
+const void *
+key(std::uintptr_t n) {
+  // aligned like AST nodes, with qualifier-like low bits
+  return reinterpret_cast<const void *>(0x10000 + (n >> 3) * 16 + (n & 7));
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(opaque_ptr_map)
+
+BOOST_AUTO_TEST_CASE(insert_and_find_test) {
+  BOOST_TEST_CHECKPOINT("inserted values are found");
+  OpaquePtrMap<std::string> map;
+  BOOST_CHECK(map.empty());
+  BOOST_CHECK(map.find(key(1)) == nullptr);
+  BOOST_CHECK(map.insert(key(1), "one").second);
+  BOOST_CHECK(!map.insert(key(1), "uno").second);
+  BOOST_CHECK(*map.find(key(1)) == "one");
+  map[key(2)] = "two";
+  BOOST_CHECK(*map.find(key(2)) == "two");
+  BOOST_CHECK(map.size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(grow_test) {
+  BOOST_TEST_CHECKPOINT("entries survive growing the table");
+  OpaquePtrMap<unsigned> map;
+  for (unsigned i = 0; i < 10000; ++i) {
+    map.insert(key(i), i);
+  }
+  BOOST_CHECK(map.size() == 10000);
+  for (unsigned i = 0; i < 10000; ++i) {
+    const auto value = map.find(key(i));
+    BOOST_REQUIRE(value);
+    BOOST_CHECK(*value == i);
+  }
+  BOOST_CHECK(map.find(key(10000)) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(random_operations_test) {
+  BOOST_TEST_CHECKPOINT("the table agrees with std::map");
+  std::mt19937 engine(20170101);
+  std::uniform_int_distribution<int> keys(0, 300);
+  std::uniform_int_distribution<int> operations(0, 2);
+  OpaquePtrMap<int> map;
+  std::map<const void *, int> reference;
+  for (int i = 0; i < 100000; ++i) {
+    const auto k = key(keys(engine));
+    switch (operations(engine)) {
+    case 0:
+      BOOST_CHECK(map.insert(k, i).second == reference.emplace(k, i).second);
+      break;
+    case 1: BOOST_CHECK(map.erase(k) == (reference.erase(k) == 1)); break;
+    default: {
+      const auto value = map.find(k);
+      const auto iter = reference.find(k);
+      BOOST_REQUIRE((value != nullptr) == (iter != reference.end()));
+      BOOST_CHECK(!value || *value == iter->second);
+    }
+    }
+    BOOST_CHECK(map.size() == reference.size());
+  }
+  size_t visited = 0;
+  map.forEach([&](const void *k, int value) {
+    ++visited;
+    BOOST_CHECK(reference.at(k) == value);
+  });
+  BOOST_CHECK(visited == reference.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
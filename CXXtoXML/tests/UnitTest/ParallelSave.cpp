@@ -0,0 +1,100 @@
+#define BOOST_TEST_MODULE ParallelSave
+#include <boost/test/included/unit_test.hpp>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <libxml/xmlsave.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ParallelSave.h"
+
+namespace {
+
+std::string
+makeProgram(const std::string &decls) {
+  return "<Program source=\"a.cpp\"><clangAST>"
+         "<clangDecl class=\"TranslationUnit\">"
+      + decls + "</clangDecl></clangAST></Program>";
+}
+
+const char decls[] =
+    "<xcodemlTypeTable><pointerType type=\"Pointer0\" ref=\"int\"/>"
+    "</xcodemlTypeTable><xcodemlNnsTable/>"
+    "<clangDecl class=\"Var\" xcodemlType=\"Pointer0\">"
+    "<name>p</name><comment>/* \xc3\xa9t\xc3\xa9 &lt; &amp; */</comment>"
+    "<clangStmt class=\"StringLiteral\">\"\xe2\x86\x92\"</clangStmt>"
+    "</clangDecl><!-- trace -->"
+    "<clangDecl class=\"Function\" is_implicit=\"1\" "
+    "name=\"a&quot;b\"><name/><params/><body><x/></body></clangDecl>";
+
+xmlDocPtr
+parse(const std::string &xml) {
+  return xmlReadMemory(xml.data(), xml.size(), "", nullptr, 0);
+}
+
+std::string
+save(xmlDocPtr doc, int options) {
+  xmlBufferPtr buffer = xmlBufferCreate();
+  xmlSaveCtxtPtr ctxt = xmlSaveToBuffer(buffer, "UTF-8", options);
+  xmlSaveDoc(ctxt, doc);
+  xmlSaveClose(ctxt);
+  const std::string s(reinterpret_cast<const char *>(buffer->content));
+  xmlBufferFree(buffer);
+  return s;
+}
+
+std::string
+join(const std::vector<std::string> &chunks) {
+  std::string s;
+  for (const auto &chunk : chunks) {
+    s += chunk;
+  }
+  return s;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(parallel_save)
+
+BOOST_AUTO_TEST_CASE(identical_test) {
+  BOOST_TEST_CHECKPOINT("the pieces make up what xmlSaveDoc writes");
+  xmlDocPtr doc = parse(makeProgram(decls));
+  for (const int options : {0, static_cast<int>(XML_SAVE_FORMAT)}) {
+    const auto expected = save(doc, options);
+    const auto chunks = saveDocument(doc, options, 3);
+    BOOST_CHECK(chunks.size() == 7);
+    BOOST_CHECK(join(chunks) == expected);
+    BOOST_TEST_CHECKPOINT("the document is left as it was");
+    BOOST_CHECK(save(doc, options) == expected);
+  }
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_CASE(fallback_test) {
+  BOOST_TEST_CHECKPOINT("text among the children is saved in one piece");
+  xmlDocPtr doc = parse(makeProgram(std::string(decls) + "text"));
+  const auto chunks = saveDocument(doc, XML_SAVE_FORMAT, 3);
+  BOOST_CHECK(chunks.size() == 1);
+  BOOST_CHECK(join(chunks) == save(doc, XML_SAVE_FORMAT));
+  xmlFreeDoc(doc);
+
+  BOOST_TEST_CHECKPOINT("so is a translation unit without children");
+  doc = parse(makeProgram(""));
+  BOOST_CHECK(saveDocument(doc, XML_SAVE_FORMAT, 3).size() == 1);
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_CASE(write_test) {
+  BOOST_TEST_CHECKPOINT("the chunks are written in order");
+  FILE *file = std::tmpfile();
+  BOOST_REQUIRE(file);
+  BOOST_CHECK(writeChunks(fileno(file), {"<a>", "", "b", "</a>\n"}));
+  std::rewind(file);
+  char content[16] = {};
+  BOOST_CHECK(std::fread(content, 1, sizeof content - 1, file) == 9);
+  BOOST_CHECK(std::string(content) == "<a>b</a>\n");
+  std::fclose(file);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
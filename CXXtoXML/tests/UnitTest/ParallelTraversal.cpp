@@ -0,0 +1,124 @@
+#define BOOST_TEST_MODULE ParallelTraversal
+#include <boost/test/included/unit_test.hpp>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <string>
+#include <vector>
+
+#include "ParallelTraversal.h"
+
+namespace {
+
+std::string
+dump(xmlNodePtr node) {
+  xmlBufferPtr buffer = xmlBufferCreate();
+  xmlNodeDump(buffer, node->doc, node, 0, 0);
+  const std::string s(reinterpret_cast<const char *>(buffer->content));
+  xmlBufferFree(buffer);
+  return s;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(parallel_traversal)
+
+BOOST_AUTO_TEST_CASE(tree_test) {
+  BOOST_TEST_CHECKPOINT("trees are copied exactly, with placeholders renamed");
+  xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
+  xmlNodePtr from = xmlNewDocNode(doc, nullptr, BAD_CAST "from", nullptr);
+  xmlDocSetRootElement(doc, from);
+  xmlNodePtr decl = xmlNewChild(from, nullptr, BAD_CAST "clangDecl", nullptr);
+  xmlNewProp(decl, BAD_CAST "class", BAD_CAST "Var");
+  xmlNewProp(decl,
+      BAD_CAST "xcodemlType",
+      BAD_CAST makePlaceholderName(1).c_str());
+  xmlNodePtr name = xmlNewChild(decl, nullptr, BAD_CAST "name", nullptr);
+  xmlAddChild(name, xmlNewDocText(doc, BAD_CAST ""));
+  xmlAddChild(from, xmlNewDocComment(doc, BAD_CAST "a & b"));
+  xmlNodePtr nns = xmlNewTextChild(
+      from, nullptr, BAD_CAST "clangNestedNameSpecifier", BAD_CAST "x < y");
+  xmlNewProp(nns, BAD_CAST "nns", BAD_CAST makePlaceholderName(0).c_str());
+
+  std::string data;
+  for (auto child = from->children; child; child = child->next) {
+    appendTree(child, data);
+  }
+  xmlNodePtr to = xmlNewChild(from, nullptr, BAD_CAST "to", nullptr);
+  BOOST_CHECK(appendTrees(to, data, {"NNS0", "Pointer0"}));
+  BOOST_CHECK(dump(to)
+      == "<to><clangDecl class=\"Var\" xcodemlType=\"Pointer0\">"
+         "<name></name></clangDecl><!--a & b-->"
+         "<clangNestedNameSpecifier nns=\"NNS0\">x &lt; y"
+         "</clangNestedNameSpecifier></to>");
+  BOOST_CHECK(to->children->children->children->type == XML_TEXT_NODE);
+
+  BOOST_TEST_CHECKPOINT("malformed data is rejected");
+  BOOST_CHECK(!appendTrees(to, data, {"NNS0"}));
+  BOOST_CHECK(!appendTrees(to, data.substr(0, data.size() - 1), {}));
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_CASE(result_test) {
+  BOOST_TEST_CHECKPOINT("a result survives encoding");
+  int a, b;
+  TraversalResult result;
+  result.names = {{&a, false}, {&b, true}};
+  result.filterCounts = {3, 0};
+  result.nodeCounts = {{"Decl:Var", 2}, {"Stmt:IntegerLiteral", 1}};
+  result.trees = std::string("E\0)", 3);
+  const auto data = encodeTraversalResult(result);
+  TraversalResult decoded;
+  BOOST_CHECK(decodeTraversalResult(data, decoded));
+  BOOST_CHECK(decoded.names == result.names);
+  BOOST_CHECK(decoded.filterCounts == result.filterCounts);
+  BOOST_CHECK(decoded.nodeCounts == result.nodeCounts);
+  BOOST_CHECK(decoded.trees == result.trees);
+  BOOST_CHECK(!decodeTraversalResult(data.substr(0, 20), decoded));
+
+  BOOST_TEST_CHECKPOINT("so does a sequence of results");
+  TraversalResult other;
+  other.trees = "T\0";
+  const auto sequence = encodeTraversalResults({result, other});
+  std::vector<TraversalResult> results;
+  BOOST_CHECK(decodeTraversalResults(sequence, results));
+  BOOST_CHECK(results.size() == 2);
+  BOOST_CHECK(results[0].names == result.names);
+  BOOST_CHECK(results[1].trees == other.trees);
+  BOOST_CHECK(
+      !decodeTraversalResults(sequence.substr(0, data.size()), results));
+}
+
+BOOST_AUTO_TEST_CASE(partition_test) {
+  BOOST_TEST_CHECKPOINT("ranges are contiguous and balanced");
+  BOOST_CHECK(partitionByWeight({1, 1, 1, 1}, 2)
+      == (std::vector<size_t>{0, 2, 4}));
+  BOOST_CHECK(partitionByWeight({10, 1, 1, 1, 1, 1}, 2)
+      == (std::vector<size_t>{0, 1, 6}));
+  BOOST_CHECK(partitionByWeight({1, 1}, 4)
+      == (std::vector<size_t>{0, 1, 2}));
+  BOOST_CHECK(partitionByWeight({}, 4) == (std::vector<size_t>{0, 0}));
+}
+
+BOOST_AUTO_TEST_CASE(worker_test) {
+  BOOST_TEST_CHECKPOINT("results are in the order of the workers");
+  int counter = 0;
+  std::vector<std::string> results;
+  BOOST_CHECK(runWorkers(3,
+      [&](unsigned i) {
+        counter += i; // only in the worker
+        return std::string(i + 1, 'a' + i);
+      },
+      results));
+  BOOST_CHECK(results == (std::vector<std::string>{"a", "bb", "ccc"}));
+  BOOST_CHECK(counter == 0);
+
+  BOOST_TEST_CHECKPOINT("a worker may finish after another is started");
+  Worker first, second;
+  BOOST_CHECK(startWorker([]() { return std::string("first"); }, first));
+  BOOST_CHECK(startWorker([]() { return std::string("second"); }, second));
+  std::string result;
+  BOOST_CHECK(finishWorker(second, result) && result == "second");
+  BOOST_CHECK(finishWorker(first, result) && result == "first");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+#define BOOST_TEST_MODULE StringEscape
+#include <boost/test/included/unit_test.hpp>
+#include <random>
+#include <string>
+
+#include "StringEscape.h"
+
+namespace {
+
+std::string
+escape(const std::string &s) {
+  std::string out;
+  escapeStringLiteral(s.data(), s.size(), out);
+  return out;
+}
+
+std::string
+escapeScalar(const std::string &s) {
+  std::string out;
+  escapeStringLiteralScalar(s.data(), s.size(), out);
+  return out;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(string_escape)
+
+BOOST_AUTO_TEST_CASE(plain_string_test) {
+  BOOST_TEST_CHECKPOINT("printable characters are copied as they are");
+  BOOST_CHECK(escape("") == "");
+  BOOST_CHECK(escape("hello, world") == "hello, world");
+  const std::string longString(1000, 'x');
+  BOOST_CHECK(escape(longString) == longString);
+}
+
+BOOST_AUTO_TEST_CASE(special_character_test) {
+  BOOST_TEST_CHECKPOINT("special characters are escaped");
+  BOOST_CHECK(escape("\"") == "\\\"");
+  BOOST_CHECK(escape("\\") == "\\\\");
+  BOOST_CHECK(escape("a\bb\fc\nd\re\tf") == "a\\bb\\fc\\nd\\re\\tf");
+  BOOST_CHECK(escape(std::string(1, '\0')) == "\\000");
+  BOOST_CHECK(escape("\x7f") == "\\177");
+  BOOST_CHECK(escape("\xe3\x81\x82") == "\\343\\201\\202");
+}
+
+BOOST_AUTO_TEST_CASE(block_boundary_test) {
+  BOOST_TEST_CHECKPOINT("special characters are found at every position");
+  for (size_t length = 1; length <= 70; ++length) {
+    for (size_t pos = 0; pos < length; ++pos) {
+      std::string s(length, 'a');
+      s[pos] = '\n';
+      std::string expected(length + 1, 'a');
+      expected[pos] = '\\';
+      expected[pos + 1] = 'n';
+      BOOST_CHECK(escape(s) == expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(random_bytes_test) {
+  BOOST_TEST_CHECKPOINT("the fast path agrees with the scalar path");
+  std::mt19937 engine(20170101);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::uniform_int_distribution<int> printable(0x20, 0x7e);
+  for (int i = 0; i < 200; ++i) {
+    std::string s;
+    for (int j = 0; j < i * 7; ++j) {
+      s += static_cast<char>(j % 11 == 0 ? byte(engine) : printable(engine));
+    }
+    BOOST_CHECK(escape(s) == escapeScalar(s));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(append_test) {
+  BOOST_TEST_CHECKPOINT("the result is appended to the output");
+  std::string out = "prefix:";
+  escapeStringLiteral("a\"b", 3, out);
+  BOOST_CHECK(out == "prefix:a\\\"b");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+#define BOOST_TEST_MODULE TypeTableDedup
+#include <boost/test/included/unit_test.hpp>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <string>
+
+#include "TypeTableDedup.h"
+
+namespace {
+
+std::string
+makeProgram(const std::string &types, const std::string &decls) {
+  return "<Program><clangAST><clangDecl class=\"TranslationUnit\">"
+         "<xcodemlTypeTable>"
+      + types + "</xcodemlTypeTable>" + decls
+      + "</clangDecl></clangAST></Program>";
+}
+
+xmlDocPtr
+parse(const std::string &xml) {
+  return xmlReadMemory(xml.data(), xml.size(), "", nullptr, 0);
+}
+
+std::string
+dump(xmlDocPtr doc) {
+  xmlBufferPtr buffer = xmlBufferCreate();
+  xmlNodeDump(buffer, doc, xmlDocGetRootElement(doc), 0, 0);
+  const std::string s(reinterpret_cast<const char *>(buffer->content));
+  xmlBufferFree(buffer);
+  return s;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(type_table_dedup)
+
+BOOST_AUTO_TEST_CASE(merge_test) {
+  BOOST_TEST_CHECKPOINT("entries written alike are merged transitively");
+  xmlDocPtr doc = parse(makeProgram(
+      "<pointerType type=\"Pointer0\" ref=\"int\"/>"
+      "<pointerType type=\"Pointer1\" ref=\"Pointer0\"/>"
+      "<pointerType type=\"Pointer2\" ref=\"int\"/>"
+      "<pointerType type=\"Pointer3\" ref=\"Pointer2\"/>"
+      "<functionType type=\"Function0\" return_type=\"Pointer3\">"
+      "<params><paramTypeName type=\"Pointer2\">p</paramTypeName>"
+      "</params></functionType>"
+      "<functionType type=\"Function1\" return_type=\"Pointer1\">"
+      "<params><paramTypeName type=\"Pointer0\">p</paramTypeName>"
+      "</params></functionType>",
+      "<clangDecl class=\"Var\" xcodemlType=\"Pointer3\"/>"
+      "<clangDecl class=\"Function\" xcodemlType=\"Function1\"/>"));
+  BOOST_CHECK(deduplicateTypeTable(xmlDocGetRootElement(doc)) == 3);
+  BOOST_CHECK(dump(doc)
+      == makeProgram("<pointerType type=\"Pointer0\" ref=\"int\"/>"
+                     "<pointerType type=\"Pointer1\" ref=\"Pointer0\"/>"
+                     "<functionType type=\"Function0\" "
+                     "return_type=\"Pointer1\">"
+                     "<params><paramTypeName type=\"Pointer0\">p"
+                     "</paramTypeName></params></functionType>",
+             "<clangDecl class=\"Var\" xcodemlType=\"Pointer1\"/>"
+             "<clangDecl class=\"Function\" xcodemlType=\"Function0\"/>"));
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_CASE(distinct_test) {
+  BOOST_TEST_CHECKPOINT("entries written differently are kept");
+  const auto program = makeProgram(
+      "<pointerType type=\"Pointer0\" ref=\"int\"/>"
+      "<pointerType type=\"Pointer1\" ref=\"int\" reference=\"lvalue\"/>"
+      "<basicType type=\"Basic0\" name=\"int\" is_const=\"1\"/>"
+      "<basicType type=\"Basic1\" name=\"int\" is_volatile=\"1\"/>"
+      "<functionType type=\"Function0\" return_type=\"int\">"
+      "<params><paramTypeName type=\"int\">a</paramTypeName>"
+      "</params></functionType>"
+      "<functionType type=\"Function1\" return_type=\"int\">"
+      "<params><paramTypeName type=\"int\">b</paramTypeName>"
+      "</params></functionType>",
+      "");
+  xmlDocPtr doc = parse(program);
+  BOOST_CHECK(deduplicateTypeTable(xmlDocGetRootElement(doc)) == 0);
+  BOOST_CHECK(dump(doc) == program);
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_CASE(nominal_test) {
+  BOOST_TEST_CHECKPOINT("tagged and opaque types are never merged");
+  const auto program = makeProgram(
+      "<structType type=\"Struct0\"><symbols/></structType>"
+      "<structType type=\"Struct1\"><symbols/></structType>"
+      "<otherType type=\"Other0\"/>"
+      "<otherType type=\"Other1\"/>"
+      "<pointerType type=\"Pointer0\" ref=\"Struct0\"/>"
+      "<pointerType type=\"Pointer1\" ref=\"Struct1\"/>",
+      "");
+  xmlDocPtr doc = parse(program);
+  BOOST_CHECK(deduplicateTypeTable(xmlDocGetRootElement(doc)) == 0);
+  BOOST_CHECK(dump(doc) == program);
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "Arena.h"
+
+namespace {
+
+/*!
+ * \brief Prefix of every ArenaAllocated object, recording where it
+ * has been allocated (nullptr for the heap).
+ */
+union AllocationHeader {
+  Arena *owner;
+  std::max_align_t align;
+};
+
+const size_t alignment = alignof(std::max_align_t);
+
+size_t
+alignUp(size_t n) {
+  return (n + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+Arena *Arena::currentArena = nullptr;
+
+Arena::Arena(size_t size)
+    : chunkSize(size),
+      chunks(),
+      cur(nullptr),
+      end(nullptr),
+      allocations(0),
+      bytes(0) {
+}
+
+Arena::~Arena() {
+  for (auto chunk : chunks) {
+    std::free(chunk);
+  }
+}
+
+void *
+Arena::allocate(size_t size) {
+  size = alignUp(size);
+  if (static_cast<size_t>(end - cur) < size) {
+    const size_t newChunkSize = size > chunkSize ? size : chunkSize;
+    char *chunk = static_cast<char *>(std::malloc(newChunkSize));
+    if (!chunk) {
+      throw std::bad_alloc();
+    }
+    chunks.push_back(chunk);
+    cur = chunk;
+    end = chunk + newChunkSize;
+  }
+  void *p = cur;
+  cur += size;
+  ++allocations;
+  bytes += size;
+  return p;
+}
+
+size_t
+Arena::allocationCount() const {
+  return allocations;
+}
+
+size_t
+Arena::bytesAllocated() const {
+  return bytes;
+}
+
+size_t
+Arena::chunkCount() const {
+  return chunks.size();
+}
+
+Arena *
+Arena::current() {
+  return currentArena;
+}
+
+ArenaScope::ArenaScope(Arena *arena) : saved(Arena::currentArena) {
+  Arena::currentArena = arena;
+}
+
+ArenaScope::~ArenaScope() {
+  Arena::currentArena = saved;
+}
+
+void *
+ArenaAllocated::operator new(size_t size) {
+  const size_t total = sizeof(AllocationHeader) + size;
+  Arena *arena = Arena::current();
+  void *p = arena ? arena->allocate(total) : ::operator new(total);
+  auto header = static_cast<AllocationHeader *>(p);
+  header->owner = arena;
+  return header + 1;
+}
+
+void
+ArenaAllocated::operator delete(void *p) {
+  if (!p) {
+    return;
+  }
+  auto header = static_cast<AllocationHeader *>(p) - 1;
+  if (!header->owner) {
+    ::operator delete(header);
+  }
+  /* Memory in an arena is released together with the arena. */
+}
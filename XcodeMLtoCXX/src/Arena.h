@@ -0,0 +1,63 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+/*!
+ * \brief A bump allocator whose memory is released all at once.
+ *
+ * Objects of classes derived from ArenaAllocated are placed in the
+ * current arena (see ArenaScope) when one is active, and on the heap
+ * otherwise. Deleting an object placed in an arena runs its destructor
+ * but does not release the memory; every chunk is freed when the arena
+ * is destroyed, so all its objects must be gone by then.
+ */
+class Arena {
+public:
+  explicit Arena(size_t chunkSize = 64 * 1024);
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  ~Arena();
+  void *allocate(size_t);
+  size_t allocationCount() const;
+  size_t bytesAllocated() const;
+  size_t chunkCount() const;
+  static Arena *current();
+
+private:
+  friend class ArenaScope;
+  static Arena *currentArena;
+
+  size_t chunkSize;
+  std::vector<char *> chunks;
+  char *cur;
+  char *end;
+  size_t allocations;
+  size_t bytes;
+};
+
+/*!
+ * \brief Make an arena current during the lifetime of this object.
+ *
+ * ArenaScope(nullptr) suspends arena allocation, e.g. for objects
+ * that must outlive the current document.
+ */
+class ArenaScope {
+public:
+  explicit ArenaScope(Arena *);
+  ArenaScope(const ArenaScope &) = delete;
+  ArenaScope &operator=(const ArenaScope &) = delete;
+  ~ArenaScope();
+
+private:
+  Arena *saved;
+};
+
+/*!
+ * \brief Base class of objects allocated in the current arena.
+ */
+class ArenaAllocated {
+public:
+  static void *operator new(size_t);
+  static void operator delete(void *);
+};
+
+#endif /* !ARENA_H */
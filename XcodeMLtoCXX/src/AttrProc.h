@@ -35,15 +35,26 @@ public:
 
   std::vector<ReturnT>
   walkAll(xmlNodePtr node, T... args) const {
+    std::vector<ReturnT> ret;
+    walkAllWith(
+        node, [&ret](const ReturnT &v) { ret.push_back(v); }, args...);
+    return ret;
+  }
+
+  /*!
+   * \brief Process the child elements of \c node, handing each
+   * result to \c sink instead of collecting them.
+   */
+  template <typename Sink>
+  void
+  walkAllWith(xmlNodePtr node, Sink &&sink, T... args) const {
     if (!node) {
-      return {};
+      return;
     }
-    std::vector<ReturnT> ret;
     for (xmlNodePtr cur = xmlFirstElementChild(node); cur;
          cur = xmlNextElementSibling(cur)) {
-      ret.push_back(walk(cur, args...));
+      sink(walk(cur, args...));
     }
-    return ret;
   }
 
 private:
@@ -7,10 +7,12 @@
 #include <vector>
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/Support/Casting.h"
 #include "LibXMLUtil.h"
 #include "Stream.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "XMLString.h"
 #include "XMLWalker.h"
@@ -33,12 +35,15 @@ namespace cxxgen = CXXCodeGen;
 
 #define DEFINE_CCH(name) static XcodeMl::CodeFragment name(CCH_ARGS)
 
-using cxxgen::makeInnerNode;
 using cxxgen::makeTokenNode;
 using XcodeMl::CodeFragment;
 
 DEFINE_CCH(callCodeBuilder) {
-  return makeInnerNode(ProgramBuilder.walkChildren(node, src));
+  const auto acc = cxxgen::makeEmptyInnerNode();
+  ProgramBuilder.walkChildrenWith(node,
+      [&acc](const CodeFragment &child) { acc->append(child); },
+      src);
+  return acc;
 }
 
 DEFINE_CCH(BreakStmtProc) {
@@ -8,12 +8,14 @@
 #include <vector>
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/Support/Casting.h"
 #include "XMLString.h"
 #include "XMLWalker.h"
 #include "AttrProc.h"
 #include "Stream.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "Util.h"
 #include "XcodeMlNns.h"
@@ -29,6 +31,8 @@
 #include "ClangClassHandler.h"
 #include "SymbolBuilder.h"
 #include "LibXMLUtil.h"
+#include "TimeReport.h"
+#include "ConversionStats.h"
 
 namespace cxxgen = CXXCodeGen;
 
@@ -89,20 +93,47 @@ DEFINE_CB(NullProc) {
 }
 
 DEFINE_CB(EmptyProc) {
-  return makeInnerNode(w.walkChildren(node, src));
+  const auto acc = cxxgen::makeEmptyInnerNode();
+  w.walkChildrenWith(node,
+      [&acc](const StringTreeRef &child) { acc->append(child); },
+      src);
+  return acc;
 }
 
-cxxgen::StringTreeRef
-foldWithSemicolon(const std::vector<StringTreeRef> &stmts) {
-  auto node = makeVoidNode();
-  for (auto &stmt : stmts) {
-    node = node + stmt + makeTokenNode(";") + makeNewLineNode();
-  }
-  return node;
+/*!
+ * \brief Traverse the child elements of \c node and put \c delim
+ * between the results.
+ */
+StringTreeRef
+joinChildren(const std::string &delim,
+    const CodeBuilder &w,
+    xmlNodePtr node,
+    SourceInfo &src) {
+  const auto acc = cxxgen::makeEmptyInnerNode();
+  const auto delimNode = makeTokenNode(delim);
+  bool alreadyPrinted = false;
+  w.walkChildrenWith(node,
+      [&](const StringTreeRef &child) {
+        if (alreadyPrinted) {
+          acc->append(delimNode);
+        }
+        acc->append(child);
+        alreadyPrinted = true;
+      },
+      src);
+  return acc;
 }
 
 DEFINE_CB(walkChildrenWithInsertingNewLines) {
-  return foldWithSemicolon(w.walkChildren(node, src));
+  const auto acc = cxxgen::makeEmptyInnerNode();
+  w.walkChildrenWith(node,
+      [&acc](const StringTreeRef &stmt) {
+        acc->append(stmt);
+        acc->append(makeTokenNode(";"));
+        acc->append(makeNewLineNode());
+      },
+      src);
+  return acc;
 }
 
 CodeBuilder::Procedure
@@ -140,7 +171,7 @@ showBinOp(std::string Operator) {
 }
 
 const CodeBuilder::Procedure EmptySNCProc = [](
-    CB_ARGS) { return makeTokenNode(XMLString(xmlNodeGetContent(node))); };
+    CB_ARGS) { return makeContentNode(node); };
 
 /*!
  * \brief Make a procedure that outputs text content of a given
@@ -174,20 +205,18 @@ showUnaryOp(std::string Operator) {
 }
 
 DEFINE_CB(postIncrExprProc) {
-  return makeTokenNode("(") + makeInnerNode(w.walkChildren(node, src))
-      + makeTokenNode("++)");
+  return makeTokenNode("(") + EmptyProc(w, node, src) + makeTokenNode("++)");
 }
 
 DEFINE_CB(postDecrExprProc) {
-  return makeTokenNode("(") + makeInnerNode(w.walkChildren(node, src))
-      + makeTokenNode("--)");
+  return makeTokenNode("(") + EmptyProc(w, node, src) + makeTokenNode("--)");
 }
 
 DEFINE_CB(castExprProc) {
   const auto dtident = getProp(node, "type");
   const auto Tstr =
       makeDecl(src.typeTable.at(dtident), makeVoidNode(), src.typeTable);
-  const auto child = makeInnerNode(w.walkChildren(node, src));
+  const auto child = EmptyProc(w, node, src);
   return wrapWithParen(wrapWithParen(Tstr) + wrapWithParen(child));
 }
 
@@ -205,8 +234,7 @@ getParams(xmlNodePtr fnNode, const SourceInfo &src) {
   const auto params =
       findNodes(fnNode, "TypeLoc/clangDecl[@class='ParmVar']/name", src.ctxt);
   for (auto p : params) {
-    XMLString name = xmlNodeGetContent(p);
-    vec.push_back(makeTokenNode(name));
+    vec.push_back(makeContentNode(p));
   }
   return vec;
 }
@@ -276,7 +304,7 @@ DEFINE_CB(functionDeclProc) {
 }
 
 DEFINE_CB(varProc) {
-  const auto name = makeTokenNode(getContent(node));
+  const auto name = makeContentNode(node);
   const auto nnsident = getPropOrNull(node, "nns");
   if (!nnsident.hasValue()) {
     return name;
@@ -350,7 +378,7 @@ getNameFromMemberRefNode(xmlNodePtr node, const SourceInfo &src) {
 
 DEFINE_CB(memberRefProc) {
   const auto name = getNameFromMemberRefNode(node, src);
-  return makeInnerNode(w.walkChildren(node, src)) + makeTokenNode("->") + name;
+  return EmptyProc(w, node, src) + makeTokenNode("->") + name;
 }
 
 DEFINE_CB(memberAddrProc) {
@@ -358,13 +386,35 @@ DEFINE_CB(memberAddrProc) {
 }
 
 DEFINE_CB(memberPointerRefProc) {
-  return makeInnerNode(w.walkChildren(node, src)) + makeTokenNode(".*")
+  return EmptyProc(w, node, src) + makeTokenNode(".*")
       + makeTokenNode(getProp(node, "name"));
 }
 
 DEFINE_CB(compoundValueProc) {
-  return makeTokenNode("{") + makeInnerNode(w.walkChildren(node, src))
-      + makeTokenNode("}");
+  return makeTokenNode("{") + EmptyProc(w, node, src) + makeTokenNode("}");
+}
+
+/*!
+ * \brief Process an intConstantList element, the packed form of
+ * a sequence of intConstant elements in an initializer list.
+ *
+ * The whitespace-separated values become one comma-separated token,
+ * so that a huge table costs a single node.
+ */
+DEFINE_CB(intConstantListProc) {
+  const auto values = getContent(node);
+  std::string joined;
+  joined.reserve(values.size());
+  size_t pos = values.find_first_not_of(" \t\n");
+  while (pos != std::string::npos) {
+    const auto end = values.find_first_of(" \t\n", pos);
+    if (!joined.empty()) {
+      joined += ',';
+    }
+    joined.append(values, pos, end == std::string::npos ? end : end - pos);
+    pos = values.find_first_not_of(" \t\n", end);
+  }
+  return makeTokenNode(joined);
 }
 
 DEFINE_CB(thisExprProc) {
@@ -439,15 +489,20 @@ DEFINE_CB(ifStatementProc) {
 DEFINE_CB(switchStatementProc) {
   auto cond = findFirst(node, "value", src.ctxt);
   auto body = findFirst(node, "body", src.ctxt);
+  const auto stmts = cxxgen::makeEmptyInnerNode();
+  w.walkChildrenWith(body,
+      [&stmts](const StringTreeRef &stmt) {
+        stmts->append(stmt);
+        stmts->append(makeNewLineNode());
+      },
+      src);
   return makeTokenNode("switch") + wrapWithParen(w.walk(cond, src))
-      + makeTokenNode("{") + insertNewLines(w.walkChildren(body, src))
-      + makeTokenNode("}");
+      + makeTokenNode("{") + stmts + makeTokenNode("}");
 }
 
 DEFINE_CB(caseLabelProc) {
   auto value = findFirst(node, "value", src.ctxt);
-  return makeTokenNode("case") + makeInnerNode(w.walkChildren(value, src))
-      + makeTokenNode(":");
+  return makeTokenNode("case") + EmptyProc(w, value, src) + makeTokenNode(":");
 }
 
 DEFINE_CB(defaultLabelProc) {
@@ -496,8 +551,7 @@ DEFINE_CB(valueProc) {
   const auto child = findFirst(node, "*", src.ctxt);
   if (getName(child) == "value") {
     // aggregate (See {#sec:program.value})
-    const auto grandchildren = w.walkChildren(child, src);
-    return wrapWithBrace(join(",", grandchildren));
+    return wrapWithBrace(joinChildren(",", w, child, src));
   }
   return w.walk(child, src);
 }
@@ -538,19 +592,7 @@ DEFINE_CB(newArrayExprProc) {
 }
 
 DEFINE_CB(argumentsProc) {
-  auto acc = makeTokenNode("(");
-  bool alreadyPrinted = false;
-  for (xmlNodePtr arg = node->children; arg; arg = arg->next) {
-    if (arg->type != XML_ELEMENT_NODE) {
-      continue;
-    }
-    if (alreadyPrinted) {
-      acc = acc + makeTokenNode(",");
-    }
-    acc = acc + w.walk(arg, src);
-    alreadyPrinted = true;
-  }
-  return acc + makeTokenNode(")");
+  return wrapWithParen(joinChildren(",", w, node, src));
 }
 
 DEFINE_CB(condExprProc) {
@@ -738,6 +780,7 @@ const CodeBuilder ProgramBuilder("ProgramBuilder",
         std::make_tuple("functionDefinition", functionDefinitionProc),
         std::make_tuple("functionDecl", functionDeclProc),
         std::make_tuple("intConstant", EmptySNCProc),
+        std::make_tuple("intConstantList", intConstantListProc),
         std::make_tuple("floatConstant", EmptySNCProc),
         std::make_tuple("moeConstant", EmptySNCProc),
         std::make_tuple("booleanConstant", EmptySNCProc),
@@ -858,12 +901,21 @@ buildCode(
       parseTypeTable(typeTableNode, ctxt, ss),
       analyzeNnsTable(nnsTableNode, ctxt),
   };
+  if (ConversionStats::isEnabled()) {
+    ConversionStats::setTypeCount(src.typeTable.getKeys().size());
+  }
 
-  cxxgen::Stream out;
   xmlNodePtr globalDeclarations =
       findFirst(rootNode, "/XcodeProgram/globalDeclarations", src.ctxt);
-  separateByBlankLines(ProgramBuilder.walkChildren(globalDeclarations, src))
-      ->flush(out);
+  StringTreeRef code;
+  {
+    PhaseTimer timer("program-builder");
+    code = separateByBlankLines(
+        ProgramBuilder.walkChildren(globalDeclarations, src));
+  }
 
+  PhaseTimer timer("output");
+  cxxgen::Stream out;
+  code->flush(out);
   ss << out.str();
 }
@@ -0,0 +1,74 @@
+#include <cstdio>
+#include <map>
+#include <ostream>
+#include <string>
+#include "ConversionStats.h"
+
+bool ConversionStats::enabled = false;
+
+namespace {
+
+std::map<std::string, std::map<std::string, size_t>> elements;
+size_t types = 0;
+size_t outputBytes = 0;
+
+void
+printString(std::ostream &os, const std::string &s) {
+  os << '"';
+  for (const char c : s) {
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof buf, "\\u%04x", c);
+      os << buf;
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+} // namespace
+
+void
+ConversionStats::enable() {
+  enabled = true;
+}
+
+void
+ConversionStats::countElement(
+    const std::string &walker, const std::string &element) {
+  ++elements[walker][element];
+}
+
+void
+ConversionStats::setTypeCount(size_t count) {
+  types = count;
+}
+
+void
+ConversionStats::setOutputBytes(size_t bytes) {
+  outputBytes = bytes;
+}
+
+void
+ConversionStats::print(std::ostream &os, const std::string &source) {
+  os << "{\"source\": ";
+  printString(os, source);
+  os << ", \"elements\": {";
+  for (auto walker = elements.begin(); walker != elements.end(); ++walker) {
+    os << (walker == elements.begin() ? "" : ", ");
+    printString(os, walker->first);
+    os << ": {";
+    const auto &counts = walker->second;
+    for (auto count = counts.begin(); count != counts.end(); ++count) {
+      os << (count == counts.begin() ? "" : ", ");
+      printString(os, count->first);
+      os << ": " << count->second;
+    }
+    os << "}";
+  }
+  os << "}, \"types\": " << types << ", \"outputBytes\": " << outputBytes
+     << "}" << std::endl;
+}
@@ -0,0 +1,34 @@
+#ifndef CONVERSIONSTATS_H
+#define CONVERSIONSTATS_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+/*!
+ * \brief The workload of a run (`--stats`): the elements each XMLWalker
+ * handled, the types in the type table and the size of the output.
+ */
+class ConversionStats {
+public:
+  static void enable();
+  static bool
+  isEnabled() {
+    return enabled;
+  }
+  /*!
+   * \brief Counts an element \c element that the walker \c walker ran
+   * its procedure for.
+   */
+  static void countElement(
+      const std::string &walker, const std::string &element);
+  static void setTypeCount(size_t count);
+  static void setOutputBytes(size_t bytes);
+  /*! \brief Prints the statistics of \c source as a line of JSON. */
+  static void print(std::ostream &os, const std::string &source);
+
+private:
+  static bool enabled;
+};
+
+#endif /* !CONVERSIONSTATS_H */
@@ -0,0 +1,239 @@
+#include <climits>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <libxml/tree.h>
+#include <libxml/parser.h>
+#include <libxml/xpath.h>
+#include "llvm/ADT/Optional.h"
+#include "LibXMLUtil.h"
+#include "DocumentLoader.h"
+
+/*!
+ * \brief Return the profile named \c name ("legacy", "default",
+ * "noblanks", "compact", "huge", "nodict" or "fast").
+ */
+llvm::Optional<ParseProfile>
+getParseProfileByName(const std::string &name) {
+  const std::map<std::string, ParseProfile> profiles = {
+      {"legacy", ParseProfile::Legacy},
+      {"default", ParseProfile::Default},
+      {"noblanks", ParseProfile::NoBlanks},
+      {"compact", ParseProfile::Compact},
+      {"huge", ParseProfile::Huge},
+      {"nodict", ParseProfile::NoDict},
+      {"fast", ParseProfile::Fast},
+  };
+  const auto iter = profiles.find(name);
+  if (iter == profiles.end()) {
+    return llvm::Optional<ParseProfile>();
+  }
+  return iter->second;
+}
+
+/*!
+ * \brief Return the \c xmlParserOption flags that \c profile stands for.
+ */
+int
+getParseOptions(ParseProfile profile) {
+  switch (profile) {
+  case ParseProfile::Legacy:
+  case ParseProfile::Default: return 0;
+  case ParseProfile::NoBlanks: return XML_PARSE_NOBLANKS;
+  case ParseProfile::Compact: return XML_PARSE_COMPACT;
+  case ParseProfile::Huge: return XML_PARSE_HUGE;
+  case ParseProfile::NoDict: return XML_PARSE_NODICT;
+  case ParseProfile::Fast:
+    return XML_PARSE_NOBLANKS | XML_PARSE_COMPACT | XML_PARSE_HUGE;
+  }
+  return 0;
+}
+
+/*!
+ * \brief Map \c filename into memory and parse it with \c options.
+ * \param doc Set to the parsed document (nullptr if malformed).
+ * \return false if \c filename cannot be mapped (e.g. it is
+ * a pipe, an empty file, or larger than \c xmlReadMemory accepts).
+ */
+static bool
+readMappedFile(const std::string &filename, int options, xmlDocPtr &doc) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0
+      || st.st_size > INT_MAX) {
+    close(fd);
+    return false;
+  }
+  const size_t size = st.st_size;
+  void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+  madvise(addr, size, MADV_SEQUENTIAL);
+  /* The document owns copies of everything it needs from the buffer,
+   * so the mapping can be released right after parsing. */
+  doc = xmlReadMemory(static_cast<const char *>(addr),
+      static_cast<int>(size),
+      filename.c_str(),
+      nullptr,
+      options);
+  munmap(addr, size);
+  return true;
+}
+
+/*!
+ * \brief Parse the XcodeML document \c filename ("-" for stdin).
+ * \return nullptr if the document cannot be read or is malformed.
+ */
+xmlDocPtr
+loadDocument(const std::string &filename, ParseProfile profile) {
+  if (profile == ParseProfile::Legacy) {
+    return xmlParseFile(filename.c_str());
+  }
+  const int options = getParseOptions(profile);
+  xmlDocPtr doc = nullptr;
+  if (filename != "-" && readMappedFile(filename, options, doc)) {
+    return doc;
+  }
+  return xmlReadFile(filename.c_str(), nullptr, options);
+}
+
+namespace {
+
+/*!
+ * \brief A table of the document into which fragments are spliced.
+ *
+ * The entries of a fragment are inserted before the entries of the
+ * document itself, which may refer to them. An entry whose identifier
+ * (\c idName) is already in the table is skipped: within one
+ * translation unit an identifier always denotes the same entity.
+ */
+class SplicedTable {
+public:
+  SplicedTable(xmlNodePtr table, const char *idName)
+      : table(table),
+        firstOwnEntry(table ? table->children : nullptr),
+        idName(idName) {
+    for (auto entry = firstOwnEntry; entry; entry = entry->next) {
+      if (idName && entry->type == XML_ELEMENT_NODE) {
+        ids.insert(getId(entry));
+      }
+    }
+  }
+
+  void
+  splice(xmlNodePtr fragmentTable) {
+    if (!table || !fragmentTable) {
+      return;
+    }
+    for (auto entry = fragmentTable->children; entry; entry = entry->next) {
+      if (entry->type != XML_ELEMENT_NODE
+          || (idName && !ids.insert(getId(entry)).second)) {
+        continue;
+      }
+      const auto copy = xmlDocCopyNode(entry, table->doc, 1);
+      if (firstOwnEntry) {
+        xmlAddPrevSibling(firstOwnEntry, copy);
+      } else {
+        xmlAddChild(table, copy);
+      }
+    }
+  }
+
+private:
+  std::string
+  getId(xmlNodePtr entry) const {
+    return getPropOrNull(entry, idName).getValueOr("");
+  }
+
+  xmlNodePtr table;
+  xmlNodePtr firstOwnEntry;
+  const char *idName;
+  std::set<std::string> ids;
+};
+
+} // namespace
+
+/*!
+ * \brief Replace each \c <fragmentRef name="..."/> in the global
+ * declarations of \c doc with the declarations of the fragment
+ * \c fragmentDir/name.xcodeml, and add its type table, NNS table and
+ * global symbols to those of \c doc.
+ *
+ * Fragments are written by CXXtoXML with \c -header-fragments. The
+ * result is the document that would have been written without the
+ * option.
+ * \param failedFragment Set to the path of a fragment that cannot be
+ * parsed.
+ * \return false if a fragment cannot be parsed.
+ */
+bool
+resolveFragments(xmlDocPtr doc,
+    const std::string &fragmentDir,
+    ParseProfile profile,
+    std::string &failedFragment) {
+  const auto root = xmlDocGetRootElement(doc);
+  const auto globalDeclarations =
+      findChildElement(root, "globalDeclarations");
+  std::vector<xmlNodePtr> refs;
+  for (auto child = globalDeclarations ? globalDeclarations->children
+                                       : nullptr;
+       child;
+       child = child->next) {
+    if (isElement(child, "fragmentRef")) {
+      refs.push_back(child);
+    }
+  }
+  if (refs.empty()) {
+    return true;
+  }
+  SplicedTable typeTable(findChildElement(root, "typeTable"), "type");
+  SplicedTable nnsTable(findChildElement(root, "nnsTable"), "nns");
+  SplicedTable globalSymbols(findChildElement(root, "globalSymbols"), nullptr);
+
+  std::map<std::string, xmlDocPtr> fragments;
+  bool ok = true;
+  for (const auto ref : refs) {
+    const auto path =
+        fragmentDir + "/" + getProp(ref, "name") + ".xcodeml";
+    // a header without include guards may be referred to twice,
+    // but its entries are added once
+    auto &fragment = fragments[path];
+    if (!fragment) {
+      fragment = loadDocument(path, profile);
+      if (!fragment) {
+        failedFragment = path;
+        ok = false;
+        break;
+      }
+      const auto fragmentRoot = xmlDocGetRootElement(fragment);
+      typeTable.splice(findChildElement(fragmentRoot, "typeTable"));
+      nnsTable.splice(findChildElement(fragmentRoot, "nnsTable"));
+      globalSymbols.splice(findChildElement(fragmentRoot, "globalSymbols"));
+    }
+    const auto decls = findChildElement(
+        xmlDocGetRootElement(fragment), "globalDeclarations");
+    for (auto decl = decls ? decls->children : nullptr; decl;
+         decl = decl->next) {
+      if (decl->type == XML_ELEMENT_NODE) {
+        xmlAddPrevSibling(ref, xmlDocCopyNode(decl, doc, 1));
+      }
+    }
+    xmlUnlinkNode(ref);
+    xmlFreeNode(ref);
+  }
+  for (auto &fragment : fragments) {
+    xmlFreeDoc(fragment.second);
+  }
+  return ok;
+}
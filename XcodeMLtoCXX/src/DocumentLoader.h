@@ -0,0 +1,35 @@
+#ifndef DOCUMENTLOADER_H
+#define DOCUMENTLOADER_H
+
+/*!
+ * \brief libxml2 option sets with which an XcodeML document is parsed.
+ */
+enum class ParseProfile {
+  /*! \c xmlParseFile with libxml2's default settings. */
+  Legacy,
+  /*! \c xmlReadMemory on a mapped file, no extra options. */
+  Default,
+  /*! Drop ignorable whitespace text nodes (XML_PARSE_NOBLANKS). */
+  NoBlanks,
+  /*! Store short text contents inside the nodes (XML_PARSE_COMPACT). */
+  Compact,
+  /*! Lift libxml2's size limits on text nodes (XML_PARSE_HUGE). */
+  Huge,
+  /*! Do not intern names into a dictionary (XML_PARSE_NODICT). */
+  NoDict,
+  /*! NoBlanks, Compact and Huge combined, with dictionary interning. */
+  Fast,
+};
+
+llvm::Optional<ParseProfile> getParseProfileByName(const std::string &);
+
+int getParseOptions(ParseProfile);
+
+xmlDocPtr loadDocument(const std::string &filename, ParseProfile);
+
+bool resolveFragments(xmlDocPtr doc,
+    const std::string &fragmentDir,
+    ParseProfile,
+    std::string &failedFragment);
+
+#endif /* !DOCUMENTLOADER_H */
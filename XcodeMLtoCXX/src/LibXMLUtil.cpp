@@ -12,8 +12,10 @@
 #include <libxml/parser.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "LibXMLUtil.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "XcodeMlNns.h"
 #include "XcodeMlName.h"
@@ -98,6 +100,49 @@ getName(xmlNodePtr node) {
   return static_cast<XMLString>(node->name);
 }
 
+/*!
+ * \brief Return true if \c node is an element named \c name.
+ * \pre \c node is not null.
+ */
+bool
+isElement(xmlNodePtr node, const char *name) {
+  return node->type == XML_ELEMENT_NODE
+      && xmlStrEqual(node->name, BAD_CAST name);
+}
+
+/*!
+ * \brief Return the first child element of \c node named \c name,
+ * or nullptr (also if \c node is null).
+ *
+ * Unlike \c findFirst, it needs no XPath context, so it can be used
+ * from several threads on different documents.
+ */
+xmlNodePtr
+findChildElement(xmlNodePtr node, const char *name) {
+  for (auto child = node ? node->children : nullptr; child;
+       child = child->next) {
+    if (isElement(child, name)) {
+      return child;
+    }
+  }
+  return nullptr;
+}
+
+/*!
+ * \brief Return the value of the attribute \c attr of \c node
+ * without copying it, or nullptr if there is none.
+ *
+ * The value lives as long as the attribute.
+ */
+const char *
+findProp(xmlNodePtr node, const char *attr) {
+  const auto prop = xmlHasProp(node, BAD_CAST attr);
+  if (!prop || !prop->children || !prop->children->content) {
+    return nullptr;
+  }
+  return reinterpret_cast<const char *>(prop->children->content);
+}
+
 bool
 isTrueProp(xmlNodePtr node, const char *name, bool default_value) {
   if (!xmlHasProp(node, BAD_CAST name)) {
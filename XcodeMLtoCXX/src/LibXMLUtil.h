@@ -17,6 +17,9 @@ std::string getProp(xmlNodePtr node, const std::string &attr);
 llvm::Optional<std::string> getPropOrNull(xmlNodePtr, const std::string &);
 std::string getContent(xmlNodePtr);
 std::string getName(xmlNodePtr);
+bool isElement(xmlNodePtr node, const char *name);
+xmlNodePtr findChildElement(xmlNodePtr node, const char *name);
+const char *findProp(xmlNodePtr node, const char *attr);
 
 /* Utility for XcodeML */
 bool isTrueProp(xmlNodePtr node, const char *name, bool default_value);
@@ -5,15 +5,18 @@
 #include <vector>
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/Support/Casting.h"
 #include "LibXMLUtil.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "XcodeMlNns.h"
 #include "XcodeMlType.h"
 #include "XcodeMlEnvironment.h"
 #include "XMLString.h"
 #include "XMLWalker.h"
+#include "TimeReport.h"
 
 using NnsAnalyzer = XMLWalker<void, xmlXPathContextPtr, XcodeMl::NnsMap &>;
 
@@ -42,6 +45,7 @@ const NnsAnalyzer XcodeMLNNSAnalyzer("NnsAnalyzer",
 
 XcodeMl::NnsMap
 analyzeNnsTable(xmlNodePtr nnsTable, xmlXPathContextPtr ctxt) {
+  PhaseTimer timer("nns-table");
   if (nnsTable == nullptr) {
     return initialNnsMap;
   }
@@ -61,7 +61,19 @@ shouldInterleaveSpace(char last, char next) {
 }
 
 Stream &Stream::operator<<(const std::string &token) {
-  if (token.empty()) {
+  return write(token.data(), token.size());
+}
+
+Stream &Stream::operator<<(char c) {
+  return (*this) << std::string(1, c);
+}
+
+/*!
+ * \brief Output \c len characters starting at \c token as a token.
+ */
+Stream &
+Stream::write(const char *token, size_t len) {
+  if (len == 0) {
     return *this;
   }
 
@@ -70,15 +82,11 @@ Stream &Stream::operator<<(const std::string &token) {
   if (shouldInterleaveSpace(lastChar, token[0])) {
     emit(" ");
   }
-  emit(token);
+  emit(token, len);
 
   return *this;
 }
 
-Stream &Stream::operator<<(char c) {
-  return (*this) << std::string(1, c);
-}
-
 void
 Stream::outputIndentation() {
   if (alreadyIndented) {
@@ -100,4 +108,13 @@ Stream::emit(const std::string &str) {
   ss << str;
   lastChar = str.back();
 }
+
+void
+Stream::emit(const char *str, size_t len) {
+  if (len == 0) {
+    return;
+  }
+  ss.write(str, len);
+  lastChar = str[len - 1];
+}
 }
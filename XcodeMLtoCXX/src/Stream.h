@@ -21,10 +21,12 @@ public:
   Stream &operator<<(const newline_t &);
   Stream &operator<<(const std::string &);
   Stream &operator<<(char);
+  Stream &write(const char *, size_t);
 
 private:
   void outputIndentation();
   void emit(const std::string &);
+  void emit(const char *, size_t);
 
   std::stringstream ss;
   size_t curIndent;
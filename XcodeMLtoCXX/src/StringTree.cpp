@@ -1,9 +1,15 @@
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <sstream>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/Support/Casting.h"
 
+#include "Arena.h"
 #include "Stream.h"
 #include "StringTree.h"
 
@@ -74,31 +80,166 @@ TokenNode::flush(Stream &ss) const {
 
 InnerNode *
 TokenNode::lift() const {
-  std::vector<StringTreeRef> v({std::make_shared<TokenNode>(token)});
+  /* Tokens are immutable, so the new node can share this one. */
+  std::vector<StringTreeRef> v({StringTreeRef(const_cast<TokenNode *>(this))});
+  InnerNode *node = new InnerNode(v);
+  return node;
+}
+
+bool
+BorrowedTokenNode::classof(const StringTree *node) {
+  return node->getKind() == StringTreeKind::BorrowedToken;
+}
+
+BorrowedTokenNode::BorrowedTokenNode(const char *s, size_t len)
+    : StringTree(StringTreeKind::BorrowedToken), token(s), length(len) {
+}
+
+StringTree *
+BorrowedTokenNode::clone() const {
+  BorrowedTokenNode *copy = new BorrowedTokenNode(*this);
+  return copy;
+}
+
+void
+BorrowedTokenNode::flush(Stream &ss) const {
+  ss.write(token, length);
+}
+
+InnerNode *
+BorrowedTokenNode::lift() const {
+  std::vector<StringTreeRef> v(
+      {StringTreeRef(const_cast<BorrowedTokenNode *>(this))});
   InnerNode *node = new InnerNode(v);
   return node;
 }
 
 void
 InnerNode::amend(const StringTreeRef &node) {
-  std::unique_ptr<InnerNode> IN(node->lift());
-  std::copy(
-      IN->children.begin(), IN->children.end(), std::back_inserter(children));
+  if (const auto IN = llvm::dyn_cast<InnerNode>(node.get())) {
+    children.insert(children.end(), IN->children.begin(), IN->children.end());
+  } else {
+    children.push_back(node);
+  }
 }
 
+/*!
+ * \brief Add \c node as the last child (without flattening it).
+ */
+void
+InnerNode::append(const StringTreeRef &node) {
+  children.push_back(node);
+}
+
+namespace {
+
+/*! \brief The nodes shared by every occurrence of their token. */
+struct InternedTokens {
+  std::unordered_map<std::string, StringTreeRef> nodes;
+  /*! the length of the longest token, to reject the others cheaply */
+  size_t maxLength;
+};
+
+/*!
+ * \brief Return the shared node for \c s if \c s is one of the
+ * punctuators or keywords that code generation emits over and over.
+ */
+StringTreeRef
+getInternedToken(const std::string &s) {
+  static const InternedTokens tokens = [] {
+    /* Interned nodes outlive every document arena. */
+    ArenaScope heap(nullptr);
+    InternedTokens t{{}, 0};
+    for (const char *token : {"",
+             "\n",
+             "(",
+             ")",
+             "[",
+             "]",
+             "{",
+             "}",
+             ";",
+             ",",
+             ":",
+             "::",
+             "=",
+             "*",
+             "&",
+             "&&",
+             "~",
+             "<",
+             ">",
+             ".",
+             "->",
+             "...",
+             "case",
+             "const",
+             "default",
+             "delete",
+             "else",
+             "enum",
+             "if",
+             "new",
+             "operator",
+             "private",
+             "protected",
+             "public",
+             "return",
+             "sizeof",
+             "struct",
+             "union",
+             "virtual",
+             "volatile",
+             "while"}) {
+      t.nodes.emplace(token, StringTreeRef(new TokenNode(token)));
+      t.maxLength = std::max(t.maxLength, std::strlen(token));
+    }
+    return t;
+  }();
+  if (s.size() > tokens.maxLength) {
+    return nullptr;
+  }
+  const auto iter = tokens.nodes.find(s);
+  return iter == tokens.nodes.end() ? nullptr : iter->second;
+}
+
+} // namespace
+
 StringTreeRef
 makeInnerNode(const std::vector<StringTreeRef> &v) {
-  return std::make_shared<InnerNode>(v);
+  return StringTreeRef(new InnerNode(v));
+}
+
+/*!
+ * \brief Make an inner node without children, to be filled
+ * with InnerNode::append.
+ */
+InnerNodeRef
+makeEmptyInnerNode() {
+  return InnerNodeRef(new InnerNode({}));
 }
 
 StringTreeRef
 makeNewLineNode() {
-  return std::make_shared<TokenNode>("\n");
+  return getInternedToken("\n");
 }
 
 StringTreeRef
 makeTokenNode(const std::string &s) {
-  return std::make_shared<TokenNode>(s);
+  if (auto interned = getInternedToken(s)) {
+    return interned;
+  }
+  return StringTreeRef(new TokenNode(s));
+}
+
+/*!
+ * \brief Make a token node that refers to \c len characters
+ * starting at \c s without copying them.
+ * \pre The characters outlive the node.
+ */
+StringTreeRef
+makeBorrowedTokenNode(const char *s, size_t len) {
+  return StringTreeRef(new BorrowedTokenNode(s, len));
 }
 
 std::string
@@ -110,7 +251,7 @@ to_string(const StringTreeRef &str) {
 
 StringTreeRef
 makeVoidNode() {
-  return std::make_shared<TokenNode>("");
+  return getInternedToken("");
 }
 
 namespace {
@@ -8,13 +8,16 @@ enum class StringTreeKind {
   Inner,
   /*! leaf node containing a string */
   Token,
+  /*! leaf node referring to a string owned by someone else */
+  BorrowedToken,
 };
 
 class InnerNode;
 
 class Stream;
 
-class StringTree {
+class StringTree : public llvm::RefCountedBase<StringTree>,
+                   public ArenaAllocated {
 public:
   explicit StringTree(StringTreeKind);
   virtual ~StringTree() = 0;
@@ -30,7 +33,7 @@ private:
   const StringTreeKind kind;
 };
 
-using StringTreeRef = std::shared_ptr<StringTree>;
+using StringTreeRef = llvm::IntrusiveRefCntPtr<StringTree>;
 
 class InnerNode : public StringTree {
 public:
@@ -41,6 +44,7 @@ public:
   void flush(Stream &) const override;
   InnerNode *lift() const override;
   void amend(const StringTreeRef &);
+  void append(const StringTreeRef &);
 
 protected:
   InnerNode(const InnerNode &) = default;
@@ -65,12 +69,39 @@ private:
   std::string token;
 };
 
+/*!
+ * \brief A leaf node that refers to text it does not own, such as
+ * the contents of the XcodeML document being converted.
+ *
+ * The text must outlive the node.
+ */
+class BorrowedTokenNode : public StringTree {
+public:
+  static bool classof(const StringTree *);
+  BorrowedTokenNode(const char *, size_t);
+  ~BorrowedTokenNode() = default;
+  StringTree *clone() const override;
+  void flush(Stream &) const override;
+  InnerNode *lift() const override;
+
+protected:
+  BorrowedTokenNode(const BorrowedTokenNode &) = default;
+
+private:
+  const char *token;
+  size_t length;
+};
+
+using InnerNodeRef = llvm::IntrusiveRefCntPtr<InnerNode>;
+
 std::string to_string(const StringTreeRef &);
 
 StringTreeRef makeVoidNode();
 StringTreeRef makeNewLineNode();
 StringTreeRef makeInnerNode(const std::vector<StringTreeRef> &);
+InnerNodeRef makeEmptyInnerNode();
 StringTreeRef makeTokenNode(const std::string &);
+StringTreeRef makeBorrowedTokenNode(const char *, size_t);
 
 StringTreeRef insertNewLines(const std::vector<StringTreeRef> &);
 StringTreeRef separateByBlankLines(const std::vector<StringTreeRef> &);
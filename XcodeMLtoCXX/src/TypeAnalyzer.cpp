@@ -10,17 +10,20 @@
 #include <libxml/parser.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/Support/Casting.h"
 #include "LibXMLUtil.h"
 #include "XMLString.h"
 #include "XMLWalker.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "XcodeMlNns.h"
 #include "XcodeMlName.h"
 #include "XcodeMlType.h"
 #include "XcodeMlUtil.h"
 #include "XcodeMlEnvironment.h"
+#include "TimeReport.h"
 #include "TypeAnalyzer.h"
 
 using TypeAnalyzer =
@@ -77,8 +80,7 @@ DEFINE_TA(functionTypeProc) {
   for (size_t i = 0, len = length(paramsNode); i < len; ++i) {
     xmlNodePtr param = nth(paramsNode, i);
     XMLString paramType(xmlGetProp(param, BAD_CAST "type"));
-    XMLString paramName(xmlNodeGetContent(param));
-    params.emplace_back(paramType, makeTokenNode(paramName));
+    params.emplace_back(paramType, makeContentNode(param));
   }
   XMLString name(xmlGetProp(node, BAD_CAST "type"));
   map.setReturnType(name, returnType);
@@ -232,6 +234,7 @@ const TypeAnalyzer XcodeMLTypeAnalyzer("TypeAnalyzer",
  */
 XcodeMl::Environment
 parseTypeTable(xmlNodePtr, xmlXPathContextPtr xpathCtx, std::stringstream &) {
+  PhaseTimer timer("type-table");
   xmlXPathObjectPtr xpathObj =
       xmlXPathEvalExpression(BAD_CAST "/XcodeProgram/typeTable/*", xpathCtx);
   if (xpathObj == nullptr) {
@@ -3,6 +3,7 @@
 
 #include <libxml/debugXML.h>
 #include <iostream>
+#include "ConversionStats.h"
 
 /*!
  * \brief A class that combines procedures into a single one
@@ -58,25 +59,47 @@ public:
   std::vector<ReturnT>
   walkAll(xmlNodePtr node, T... args) const {
     std::vector<ReturnT> values;
+    walkAllWith(
+        node, [&values](const ReturnT &v) { values.push_back(v); }, args...);
+    return values;
+  }
+
+  std::vector<ReturnT>
+  walkChildren(xmlNodePtr node, T... args) const {
+    if (node) {
+      return walkAll(node->children, args...);
+    } else {
+      return {};
+    }
+  }
+
+  /*!
+   * \brief Traverse a given XML element and subsequent elements,
+   * handing each result to \c sink instead of collecting them.
+   * \param node XML element to traverse first
+   * \param sink Function called with each result in document order.
+   * \param args... Arguments to be passed to registered procedures.
+   */
+  template <typename Sink>
+  void
+  walkAllWith(xmlNodePtr node, Sink &&sink, T... args) const {
     if (!node) {
-      return values;
+      return;
     }
     for (xmlNodePtr cur = node->type == XML_ELEMENT_NODE
              ? node
              : xmlNextElementSibling(node);
          cur;
          cur = xmlNextElementSibling(cur)) {
-      values.push_back(walk(cur, args...));
+      sink(walk(cur, args...));
     }
-    return values;
   }
 
-  std::vector<ReturnT>
-  walkChildren(xmlNodePtr node, T... args) const {
+  template <typename Sink>
+  void
+  walkChildrenWith(xmlNodePtr node, Sink &&sink, T... args) const {
     if (node) {
-      return walkAll(node->children, args...);
-    } else {
-      return {};
+      walkAllWith(node->children, sink, args...);
     }
   }
 
@@ -93,6 +116,9 @@ public:
     XMLString elemName = node->name;
     auto iter = map.find(elemName);
     if (iter != map.end()) {
+      if (ConversionStats::isEnabled()) {
+        ConversionStats::countElement(name, iter->first);
+      }
       return (iter->second)(*this, node, args...);
     } else {
       return fold(walkAll(node->children, args...));
@@ -176,6 +202,9 @@ public:
     XMLString elemName = node->name;
     auto iter = map.find(elemName);
     if (iter != map.end()) {
+      if (ConversionStats::isEnabled()) {
+        ConversionStats::countElement(name, iter->first);
+      }
       try {
         (iter->second)(*this, node, args...);
       } catch (const std::exception &e) {
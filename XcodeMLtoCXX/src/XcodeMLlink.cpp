@@ -0,0 +1,253 @@
+#include <libxml/tree.h>
+#include <libxml/parser.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <libxml/xpath.h>
+#include "llvm/ADT/Optional.h"
+#include "LibXMLUtil.h"
+#include "DocumentLoader.h"
+#include "XcodeMlLinker.h"
+
+/*
+ * XcodeMLlink: merges XcodeProgram documents into one.
+ *
+ * 1. The inputs are parsed in parallel; each becomes a LinkUnit (its
+ *    tables and global symbols) and the document is released.
+ * 2. The units are linked by pairs, round after round, in parallel.
+ * 3. The inputs are parsed again, in parallel and in batches, to write
+ *    their declarations with the new identifiers in the input order.
+ */
+
+namespace {
+
+struct Options {
+  std::vector<std::string> inputs;
+  std::string output;
+  std::string fragmentDir;
+  ParseProfile profile = ParseProfile::Fast;
+  unsigned jobs = 0;
+};
+
+void
+printUsage(const char *argv0) {
+  std::cout << "usage: " << argv0
+            << " [-o <output>] [--jobs=<n>] [--parse-profile=<profile>]"
+            << std::endl
+            << "       [--fragment-dir=<dir>] [--input-list=<file>]"
+            << " <input>..." << std::endl
+            << "  <file>: a file with one input per line" << std::endl;
+}
+
+bool
+startsWith(const std::string &s, const std::string &prefix) {
+  return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool
+parseArguments(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "-o" && i + 1 < argc) {
+      options.output = argv[++i];
+    } else if (startsWith(arg, "--jobs=")) {
+      options.jobs = std::strtoul(arg.c_str() + 7, nullptr, 10);
+    } else if (startsWith(arg, "--parse-profile=")) {
+      const auto p = getParseProfileByName(arg.substr(16));
+      if (!p.hasValue()) {
+        std::cerr << argv[0] << ": unknown parse profile: " << arg.substr(16)
+                  << std::endl;
+        return false;
+      }
+      options.profile = *p;
+    } else if (startsWith(arg, "--fragment-dir=")) {
+      options.fragmentDir = arg.substr(15);
+    } else if (startsWith(arg, "--input-list=")) {
+      std::ifstream list(arg.substr(13));
+      if (!list) {
+        std::cerr << argv[0] << ": cannot open " << arg.substr(13)
+                  << std::endl;
+        return false;
+      }
+      std::string line;
+      while (std::getline(list, line)) {
+        if (!line.empty()) {
+          options.inputs.push_back(line);
+        }
+      }
+    } else {
+      options.inputs.push_back(arg);
+    }
+  }
+  if (options.jobs == 0) {
+    options.jobs = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return true;
+}
+
+/*!
+ * \brief Parse \c filename and the fragments it refers to.
+ * \return nullptr after printing an error.
+ */
+xmlDocPtr
+loadInput(const std::string &filename, const Options &options) {
+  xmlDocPtr doc = loadDocument(filename, options.profile);
+  if (!doc) {
+    std::cerr << "XcodeMLlink: cannot parse " << filename << std::endl;
+    return nullptr;
+  }
+  auto fragmentDir = options.fragmentDir;
+  if (fragmentDir.empty()) {
+    const auto slash = filename.rfind('/');
+    fragmentDir = slash == std::string::npos ? "." : filename.substr(0, slash);
+  }
+  std::string failedFragment;
+  if (!resolveFragments(doc, fragmentDir, options.profile, failedFragment)) {
+    std::cerr << "XcodeMLlink: cannot parse " << failedFragment << std::endl;
+    xmlFreeDoc(doc);
+    return nullptr;
+  }
+  return doc;
+}
+
+/*!
+ * \brief Write to \c out the global declarations of \c filename,
+ * renamed after the entries that \c mapping gives for its tables.
+ */
+bool
+writeDeclarations(const std::string &filename,
+    const Options &options,
+    const std::vector<unsigned> &mapping,
+    const std::vector<std::string> &identifiers,
+    std::string &out) {
+  xmlDocPtr doc = loadInput(filename, options);
+  if (!doc) {
+    return false;
+  }
+  const auto entries = XcodeMl::getTableEntries(doc);
+  std::unordered_map<std::string, std::string> newNames;
+  for (size_t i = 0; i < entries.size() && i < mapping.size(); ++i) {
+    const auto id = getProp(entries[i],
+        isElement(entries[i]->parent, "nnsTable") ? "nns" : "type");
+    newNames.emplace(id, identifiers[mapping[i]]);
+  }
+  xmlBufferPtr buffer = xmlBufferCreate();
+  for (auto root = xmlDocGetRootElement(doc)->children; root;
+       root = root->next) {
+    if (!isElement(root, "globalDeclarations")) {
+      continue;
+    }
+    for (auto decl = root->children; decl; decl = decl->next) {
+      if (decl->type != XML_ELEMENT_NODE) {
+        continue;
+      }
+      XcodeMl::renameIdentifiers(decl, newNames);
+      xmlNodeDump(buffer, doc, decl, 0, 0);
+      xmlBufferCCat(buffer, "\n");
+    }
+  }
+  out.assign(reinterpret_cast<const char *>(xmlBufferContent(buffer)),
+      xmlBufferLength(buffer));
+  xmlBufferFree(buffer);
+  xmlFreeDoc(doc);
+  return true;
+}
+
+void
+writeTable(std::ostream &os,
+    const char *name,
+    const XcodeMl::LinkUnit &unit,
+    const std::vector<std::string> &identifiers,
+    bool isNns) {
+  os << "<" << name << ">\n";
+  for (size_t i = 0; i < unit.entries.size(); ++i) {
+    if (unit.entries[i].isNns == isNns) {
+      os << XcodeMl::instantiateEntry(
+                unit.entries[i], identifiers[i], identifiers)
+         << "\n";
+    }
+  }
+  os << "</" << name << ">\n";
+}
+
+} // namespace
+
+int
+main(int argc, char **argv) {
+  Options options;
+  if (!parseArguments(argc, argv, options)) {
+    return 1;
+  }
+  if (options.inputs.empty()) {
+    printUsage(argv[0]);
+    return 0;
+  }
+  xmlInitParser();
+  const auto &inputs = options.inputs;
+
+  std::vector<XcodeMl::LinkUnit> units(inputs.size());
+  std::vector<char> failed(inputs.size());
+  XcodeMl::parallelFor(inputs.size(), options.jobs, [&](size_t i) {
+    xmlDocPtr doc = loadInput(inputs[i], options);
+    if (!doc) {
+      failed[i] = true;
+      return;
+    }
+    units[i] = XcodeMl::makeLinkUnit(doc, i);
+    xmlFreeDoc(doc);
+  });
+  if (std::find(failed.begin(), failed.end(), true) != failed.end()) {
+    return 1;
+  }
+  const auto unit = XcodeMl::linkAll(std::move(units), options.jobs);
+  const auto identifiers = XcodeMl::makeIdentifiers(unit);
+
+  std::ofstream file;
+  if (!options.output.empty()) {
+    file.open(options.output);
+    if (!file) {
+      std::cerr << argv[0] << ": cannot open " << options.output
+                << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &os = options.output.empty() ? std::cout : file;
+  os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<XcodeProgram>\n";
+  writeTable(os, "typeTable", unit, identifiers, false);
+  writeTable(os, "nnsTable", unit, identifiers, true);
+  os << "<globalSymbols>\n";
+  for (auto &symbol : unit.symbols) {
+    os << XcodeMl::instantiateEntry(symbol, "", identifiers) << "\n";
+  }
+  os << "</globalSymbols>\n<globalDeclarations>\n";
+  // Bound the memory by converting a batch of inputs at a time.
+  const size_t batchSize = 4 * options.jobs;
+  std::vector<std::string> declarations(batchSize);
+  for (size_t begin = 0; begin < inputs.size(); begin += batchSize) {
+    const auto count = std::min(batchSize, inputs.size() - begin);
+    XcodeMl::parallelFor(count, options.jobs, [&](size_t i) {
+      failed[begin + i] = !writeDeclarations(inputs[begin + i],
+          options,
+          unit.documents[begin + i],
+          identifiers,
+          declarations[i]);
+    });
+    for (size_t i = 0; i < count; ++i) {
+      if (failed[begin + i]) {
+        return 1;
+      }
+      os << declarations[i];
+    }
+  }
+  os << "</globalDeclarations>\n</XcodeProgram>\n";
+  os.flush();
+  return os ? 0 : 1;
+}
@@ -10,8 +10,10 @@
 #include <cassert>
 #include <memory>
 #include <vector>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "Stream.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "XMLString.h"
 #include "XcodeMlNns.h"
@@ -21,21 +23,120 @@
 #include "TypeAnalyzer.h"
 #include "SourceInfo.h"
 #include "CodeBuilder.h"
+#include "DocumentLoader.h"
+#include "TimeReport.h"
+#include "ConversionStats.h"
+
+static void
+printUsage(const char *argv0) {
+  std::cout << "usage: " << argv0
+            << " [--parse-profile=<profile>] [--alloc-stats]"
+            << " [--fragment-dir=<dir>] [--time-report[=json]] [--stats]"
+            << " <filename>" << std::endl
+            << "  <profile>: fast (default), legacy, default, noblanks,"
+            << std::endl
+            << "             compact, huge, nodict" << std::endl
+            << "  <dir>: where the fragments of CXXtoXML -header-fragments"
+            << std::endl
+            << "         are (default: the directory of <filename>)"
+            << std::endl
+            << "  --time-report: print the time of each phase to stderr"
+            << std::endl
+            << "  --stats: print the numbers of elements, types and output"
+            << std::endl
+            << "           bytes to stderr as JSON" << std::endl;
+}
 
 int
 main(int argc, char **argv) {
-  if (argc < 2) {
-    std::cout << "usage: " << argv[0] << " <filename>" << std::endl;
+  ParseProfile profile = ParseProfile::Fast;
+  bool printAllocStats = false;
+  bool printTimeReport = false;
+  bool timeReportAsJson = false;
+  bool printStats = false;
+  std::string filename;
+  std::string fragmentDir;
+  const std::string profileOpt = "--parse-profile=";
+  const std::string fragmentDirOpt = "--fragment-dir=";
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg.compare(0, profileOpt.size(), profileOpt) == 0) {
+      const auto p = getParseProfileByName(arg.substr(profileOpt.size()));
+      if (!p.hasValue()) {
+        std::cerr << argv[0] << ": unknown parse profile: "
+                  << arg.substr(profileOpt.size()) << std::endl;
+        return 1;
+      }
+      profile = *p;
+    } else if (arg.compare(0, fragmentDirOpt.size(), fragmentDirOpt) == 0) {
+      fragmentDir = arg.substr(fragmentDirOpt.size());
+    } else if (arg == "--alloc-stats") {
+      printAllocStats = true;
+    } else if (arg == "--time-report" || arg == "--time-report=json") {
+      printTimeReport = true;
+      timeReportAsJson = arg != "--time-report";
+    } else if (arg == "--stats") {
+      printStats = true;
+    } else {
+      filename = arg;
+    }
+  }
+  if (filename.empty()) {
+    printUsage(argv[0]);
     return 0;
   }
-  std::string filename(argv[1]);
-  xmlDocPtr doc = xmlParseFile(filename.c_str());
+  if (printTimeReport) {
+    TimeReport::enable();
+  }
+  if (printStats) {
+    ConversionStats::enable();
+  }
+  if (fragmentDir.empty()) {
+    const auto slash = filename.rfind('/');
+    fragmentDir = slash == std::string::npos ? "." : filename.substr(0, slash);
+  }
+  xmlDocPtr doc;
+  {
+    PhaseTimer timer("parse");
+    doc = loadDocument(filename, profile);
+    if (!doc) {
+      std::cerr << argv[0] << ": cannot parse " << filename << std::endl;
+      return 1;
+    }
+    std::string failedFragment;
+    if (!resolveFragments(doc, fragmentDir, profile, failedFragment)) {
+      std::cerr << argv[0] << ": cannot parse " << failedFragment
+                << std::endl;
+      xmlFreeDoc(doc);
+      return 1;
+    }
+  }
   xmlNodePtr root = xmlDocGetRootElement(doc);
   xmlXPathContextPtr ctxt = xmlXPathNewContext(doc);
   std::stringstream ss;
-  buildCode(root, ctxt, ss);
-  std::cout << ss.str() << std::endl;
+  Arena arena;
+  {
+    ArenaScope scope(&arena);
+    buildCode(root, ctxt, ss);
+  }
+  if (printAllocStats) {
+    std::cerr << filename << ": " << arena.allocationCount()
+              << " objects, " << arena.bytesAllocated() << " bytes in "
+              << arena.chunkCount() << " arena chunks" << std::endl;
+  }
+  {
+    PhaseTimer timer("output");
+    std::cout << ss.str() << std::endl;
+  }
+  if (printStats) {
+    // with the newline after the code
+    ConversionStats::setOutputBytes(ss.str().size() + 1);
+    ConversionStats::print(std::cerr, filename);
+  }
   xmlXPathFreeContext(ctxt);
   xmlFreeDoc(doc);
+  if (printTimeReport) {
+    TimeReport::print(std::cerr, timeReportAsJson);
+  }
   return 0;
 }
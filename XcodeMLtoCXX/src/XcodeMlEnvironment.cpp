@@ -5,7 +5,9 @@
 #include <memory>
 #include <cassert>
 #include <libxml/tree.h>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "XcodeMlType.h"
 #include "XcodeMlEnvironment.h"
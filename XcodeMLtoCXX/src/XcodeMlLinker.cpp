@@ -0,0 +1,513 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <functional>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+#include "llvm/ADT/Optional.h"
+#include "LibXMLUtil.h"
+#include "XcodeMlLinker.h"
+
+namespace XcodeMl {
+
+namespace {
+
+const char *
+getIdAttribute(xmlNodePtr entry) {
+  return isElement(entry->parent, "nnsTable") ? "nns" : "type";
+}
+
+bool
+isTaggedType(xmlNodePtr entry) {
+  for (auto name : {"classType", "structType", "unionType", "enumType"}) {
+    if (isElement(entry, name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string
+getNameText(xmlNodePtr node) {
+  const auto name = findChildElement(node, "name");
+  if (!name) {
+    return std::string();
+  }
+  xmlChar *content = xmlNodeGetContent(name);
+  const std::string text(reinterpret_cast<const char *>(content));
+  xmlFree(content);
+  return text;
+}
+
+/*!
+ * \brief Return true if \c node declares the class or enum of its
+ * \c type attribute.
+ */
+bool
+isTagDeclaration(xmlNodePtr node) {
+  if (isElement(node, "id")) {
+    const auto sclass = findProp(node, "sclass");
+    return sclass && std::string(sclass) == "class_name";
+  }
+  if (isElement(node, "clangDecl")) {
+    const auto declClass = findProp(node, "class");
+    if (!declClass) {
+      return false;
+    }
+    const std::string c(declClass);
+    return c == "CXXRecord" || c == "Record" || c == "Enum"
+        || c == "ClassTemplateSpecialization"
+        || c == "ClassTemplatePartialSpecialization";
+  }
+  return isElement(node, "classDecl") || isElement(node, "enumDecl");
+}
+
+using EntryIndex = std::unordered_map<std::string, unsigned>;
+
+/*!
+ * \brief Record the qualified names under which the tagged types are
+ * declared in \c node. \c scope is the names of the enclosing
+ * elements joined by "::".
+ */
+void
+collectTagNames(xmlNodePtr node,
+    const std::string &scope,
+    const EntryIndex &index,
+    const std::vector<xmlNodePtr> &entries,
+    std::vector<std::set<std::string>> &names) {
+  for (auto child = node->children; child; child = child->next) {
+    if (child->type != XML_ELEMENT_NODE || isElement(child, "typeTable")
+        || isElement(child, "nnsTable")) {
+      continue;
+    }
+    const auto name = getNameText(child);
+    if (isTagDeclaration(child) && !name.empty()) {
+      const auto type = findProp(child, "type");
+      const auto iter = type ? index.find(type) : index.end();
+      if (iter != index.end() && isTaggedType(entries[iter->second])) {
+        names[iter->second].insert(scope + name);
+      }
+    }
+    collectTagNames(child,
+        name.empty() ? scope : scope + name + "::",
+        index,
+        entries,
+        names);
+  }
+}
+
+void
+appendEscaped(std::string &out, const char *s, bool isAttribute) {
+  for (; *s; ++s) {
+    switch (*s) {
+    case '&': out += "&amp;"; break;
+    case '<': out += "&lt;"; break;
+    case '>': out += "&gt;"; break;
+    case '"':
+      out += isAttribute ? "&quot;" : "\"";
+      break;
+    default: out += *s; break;
+    }
+  }
+}
+
+bool
+isBlank(const xmlChar *s) {
+  for (; s && *s; ++s) {
+    if (!isspace(*s)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * \brief Serialize \c node into \c entry, replacing references to
+ * the entries in \c index with \c \\x02. The attribute \c idAttr of
+ * \c node itself becomes \c \\x01.
+ */
+void
+serializeEntry(xmlNodePtr node,
+    const char *idAttr,
+    const EntryIndex &index,
+    LinkEntry &entry) {
+  auto &out = entry.xml;
+  out += '<';
+  out += reinterpret_cast<const char *>(node->name);
+  for (auto attr = node->properties; attr; attr = attr->next) {
+    out += ' ';
+    out += reinterpret_cast<const char *>(attr->name);
+    out += "=\"";
+    const auto value =
+        attr->children && attr->children->content
+        ? reinterpret_cast<const char *>(attr->children->content)
+        : "";
+    const auto iter = index.find(value);
+    if (idAttr && xmlStrEqual(attr->name, BAD_CAST idAttr)) {
+      out += '\x01';
+    } else if (iter != index.end()) {
+      out += '\x02';
+      entry.refs.push_back(iter->second);
+    } else {
+      appendEscaped(out, value, true);
+    }
+    out += '"';
+  }
+  if (!node->children) {
+    out += "/>";
+    return;
+  }
+  out += '>';
+  for (auto child = node->children; child; child = child->next) {
+    if (child->type == XML_ELEMENT_NODE) {
+      serializeEntry(child, nullptr, index, entry);
+    } else if (child->type == XML_TEXT_NODE && !isBlank(child->content)) {
+      appendEscaped(
+          out, reinterpret_cast<const char *>(child->content), false);
+    }
+  }
+  out += "</";
+  out += reinterpret_cast<const char *>(node->name);
+  out += '>';
+}
+
+struct VectorHash {
+  size_t
+  operator()(const std::vector<unsigned> &v) const {
+    size_t h = v.size();
+    for (auto x : v) {
+      h = h * 1000003 ^ x;
+    }
+    return h;
+  }
+};
+
+/*!
+ * \brief Return the partition of \c entries into structurally
+ * identical ones, numbered in the order of first appearance.
+ *
+ * Starting from the partition by the elements themselves, classes are
+ * split by the classes of the referred entries until nothing changes
+ * (Moore's algorithm).
+ */
+std::vector<unsigned>
+partitionEntries(const std::vector<LinkEntry> &entries, size_t &count) {
+  const size_t n = entries.size();
+  std::vector<unsigned> classes(n);
+  {
+    std::unordered_map<std::string, unsigned> ids;
+    for (size_t i = 0; i < n; ++i) {
+      const auto key = entries[i].xml + '\0' + entries[i].key;
+      classes[i] = ids.emplace(key, ids.size()).first->second;
+    }
+    count = ids.size();
+  }
+  std::vector<unsigned> signature;
+  for (;;) {
+    std::unordered_map<std::vector<unsigned>, unsigned, VectorHash> ids;
+    std::vector<unsigned> refined(n);
+    for (size_t i = 0; i < n; ++i) {
+      signature.assign(1, classes[i]);
+      for (auto ref : entries[i].refs) {
+        signature.push_back(classes[ref]);
+      }
+      refined[i] = ids.emplace(signature, ids.size()).first->second;
+    }
+    classes.swap(refined);
+    if (ids.size() == count) {
+      // Each round numbers classes in the order of first appearance.
+      return classes;
+    }
+    count = ids.size();
+  }
+}
+
+/*! \brief Remove duplicate symbols keeping the first ones. */
+void
+uniqueSymbols(std::vector<LinkEntry> &symbols) {
+  std::unordered_set<std::string> seen;
+  std::vector<LinkEntry> result;
+  for (auto &symbol : symbols) {
+    std::string key = symbol.xml;
+    for (auto ref : symbol.refs) {
+      key += '\0' + std::to_string(ref);
+    }
+    if (seen.insert(key).second) {
+      result.push_back(std::move(symbol));
+    }
+  }
+  symbols.swap(result);
+}
+
+/*! \brief Unify the structurally identical entries of \c unit. */
+void
+minimize(LinkUnit &unit) {
+  size_t count;
+  const auto classes = partitionEntries(unit.entries, count);
+  std::vector<LinkEntry> entries(count);
+  std::vector<bool> done(count);
+  for (size_t i = 0; i < unit.entries.size(); ++i) {
+    const auto c = classes[i];
+    if (done[c]) {
+      continue;
+    }
+    done[c] = true;
+    entries[c] = std::move(unit.entries[i]);
+    for (auto &ref : entries[c].refs) {
+      ref = classes[ref];
+    }
+  }
+  unit.entries.swap(entries);
+  for (auto &symbol : unit.symbols) {
+    for (auto &ref : symbol.refs) {
+      ref = classes[ref];
+    }
+  }
+  uniqueSymbols(unit.symbols);
+  for (auto &document : unit.documents) {
+    for (auto &index : document) {
+      index = classes[index];
+    }
+  }
+}
+
+std::string
+getIdentifierPrefix(const std::string &xml) {
+  const auto end = xml.find_first_of(" />", 1);
+  const auto element = xml.substr(1, end - 1);
+  const auto suffix = [&](const std::string &s) {
+    return element.size() > s.size()
+        && element.compare(element.size() - s.size(), s.size(), s) == 0;
+  };
+  if (suffix("NNS")) {
+    return "NNS";
+  }
+  if (suffix("Type")) {
+    auto prefix = element.substr(0, element.size() - 4);
+    prefix[0] = toupper(prefix[0]);
+    return prefix;
+  }
+  return "Type";
+}
+
+} // namespace
+
+/*!
+ * \brief Return the entries of \c typeTable and \c nnsTable of
+ * \c doc that have identifiers, in document order.
+ */
+std::vector<xmlNodePtr>
+getTableEntries(xmlDocPtr doc) {
+  const auto root = xmlDocGetRootElement(doc);
+  std::vector<xmlNodePtr> entries;
+  for (auto table : {"typeTable", "nnsTable"}) {
+    const auto tableNode = findChildElement(root, table);
+    for (auto entry = tableNode ? tableNode->children : nullptr; entry;
+         entry = entry->next) {
+      if (entry->type == XML_ELEMENT_NODE
+          && findProp(entry, getIdAttribute(entry))) {
+        entries.push_back(entry);
+      }
+    }
+  }
+  return entries;
+}
+
+/*!
+ * \brief Make the unit of the XcodeProgram document \c doc, the
+ * \c docIndex th input.
+ */
+LinkUnit
+makeLinkUnit(xmlDocPtr doc, size_t docIndex) {
+  const auto root = xmlDocGetRootElement(doc);
+  const auto nodes = getTableEntries(doc);
+  EntryIndex index;
+  std::vector<unsigned> identity;
+  for (unsigned i = 0; i < nodes.size(); ++i) {
+    const auto id = findProp(nodes[i], getIdAttribute(nodes[i]));
+    // the first definition wins as in TypeAnalyzer
+    identity.push_back(index.emplace(id, i).first->second);
+  }
+  std::vector<std::set<std::string>> tagNames(nodes.size());
+  collectTagNames(root, "", index, nodes, tagNames);
+
+  LinkUnit unit;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    LinkEntry entry;
+    entry.isNns = isElement(nodes[i]->parent, "nnsTable");
+    serializeEntry(nodes[i], getIdAttribute(nodes[i]), index, entry);
+    if (isTaggedType(nodes[i])) {
+      if (tagNames[i].empty()) {
+        entry.key = "\1" + std::to_string(docIndex) + ":"
+            + findProp(nodes[i], "type");
+      }
+      for (const auto &name : tagNames[i]) {
+        entry.key += name + '\0';
+      }
+    }
+    unit.entries.push_back(std::move(entry));
+  }
+  const auto globalSymbols = findChildElement(root, "globalSymbols");
+  for (auto symbol = globalSymbols ? globalSymbols->children : nullptr;
+       symbol;
+       symbol = symbol->next) {
+    if (symbol->type == XML_ELEMENT_NODE) {
+      LinkEntry entry;
+      entry.isNns = false;
+      serializeEntry(symbol, nullptr, index, entry);
+      unit.symbols.push_back(std::move(entry));
+    }
+  }
+  unit.documents.push_back(std::move(identity));
+  minimize(unit);
+  return unit;
+}
+
+/*!
+ * \brief Link two units: the documents of \c lhs come before those of
+ * \c rhs.
+ */
+LinkUnit
+linkUnits(LinkUnit &&lhs, LinkUnit &&rhs) {
+  const auto offset = static_cast<unsigned>(lhs.entries.size());
+  LinkUnit unit(std::move(lhs));
+  for (auto &entry : rhs.entries) {
+    for (auto &ref : entry.refs) {
+      ref += offset;
+    }
+    unit.entries.push_back(std::move(entry));
+  }
+  for (auto &symbol : rhs.symbols) {
+    for (auto &ref : symbol.refs) {
+      ref += offset;
+    }
+    unit.symbols.push_back(std::move(symbol));
+  }
+  for (auto &document : rhs.documents) {
+    for (auto &index : document) {
+      index += offset;
+    }
+    unit.documents.push_back(std::move(document));
+  }
+  minimize(unit);
+  return unit;
+}
+
+/*!
+ * \brief Link \c units by pairs, round after round, using \c jobs
+ * threads. The order of the documents is kept.
+ */
+LinkUnit
+linkAll(std::vector<LinkUnit> &&units, unsigned jobs) {
+  if (units.empty()) {
+    return LinkUnit();
+  }
+  while (units.size() > 1) {
+    std::vector<LinkUnit> next((units.size() + 1) / 2);
+    parallelFor(next.size(), jobs, [&](size_t i) {
+      if (2 * i + 1 < units.size()) {
+        next[i] = linkUnits(std::move(units[2 * i]),
+            std::move(units[2 * i + 1]));
+      } else {
+        next[i] = std::move(units[2 * i]);
+      }
+    });
+    units.swap(next);
+  }
+  return std::move(units.front());
+}
+
+/*!
+ * \brief Name the entries of \c unit: the kind of the element
+ * ("Pointer" for \c pointerType, "NNS" for NNS) and a number.
+ */
+std::vector<std::string>
+makeIdentifiers(const LinkUnit &unit) {
+  std::unordered_map<std::string, unsigned> counters;
+  std::vector<std::string> identifiers;
+  identifiers.reserve(unit.entries.size());
+  for (auto &entry : unit.entries) {
+    const auto prefix = getIdentifierPrefix(entry.xml);
+    identifiers.push_back(prefix + std::to_string(counters[prefix]++));
+  }
+  return identifiers;
+}
+
+/*!
+ * \brief Return the XML of \c entry with its identifier and
+ * references filled in.
+ */
+std::string
+instantiateEntry(const LinkEntry &entry,
+    const std::string &identifier,
+    const std::vector<std::string> &identifiers) {
+  std::string xml;
+  xml.reserve(entry.xml.size() + 16 * entry.refs.size());
+  size_t ref = 0;
+  for (auto c : entry.xml) {
+    if (c == '\x01') {
+      xml += identifier;
+    } else if (c == '\x02') {
+      xml += identifiers[entry.refs[ref++]];
+    } else {
+      xml += c;
+    }
+  }
+  return xml;
+}
+
+/*!
+ * \brief Replace the attribute values in \c node and its descendants
+ * that are keys of \c newNames.
+ */
+void
+renameIdentifiers(xmlNodePtr node,
+    const std::unordered_map<std::string, std::string> &newNames) {
+  for (auto attr = node->properties; attr; attr = attr->next) {
+    if (!attr->children || !attr->children->content) {
+      continue;
+    }
+    const auto iter = newNames.find(
+        reinterpret_cast<const char *>(attr->children->content));
+    if (iter != newNames.end()) {
+      xmlSetProp(node, attr->name, BAD_CAST iter->second.c_str());
+    }
+  }
+  for (auto child = node->children; child; child = child->next) {
+    if (child->type == XML_ELEMENT_NODE) {
+      renameIdentifiers(child, newNames);
+    }
+  }
+}
+
+/*!
+ * \brief Call \c body(0), ..., \c body(count - 1) on \c jobs threads.
+ */
+void
+parallelFor(
+    size_t count, unsigned jobs, const std::function<void(size_t)> &body) {
+  std::atomic<size_t> next(0);
+  const auto worker = [&]() {
+    for (size_t i; (i = next++) < count;) {
+      body(i);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned j = 1; j < std::min<size_t>(jobs, count); ++j) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace XcodeMl
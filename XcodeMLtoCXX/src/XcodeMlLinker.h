@@ -0,0 +1,70 @@
+#ifndef XCODEMLLINKER_H
+#define XCODEMLLINKER_H
+
+namespace XcodeMl {
+
+/*!
+ * \brief An entry of \c typeTable or \c nnsTable, or a global symbol
+ * (\c id), independent of the identifiers of its document.
+ */
+struct LinkEntry {
+  /*!
+   * The element as XML, where \c \\x01 stands for its own identifier
+   * and \c \\x02 for each reference to another entry.
+   */
+  std::string xml;
+  /*!
+   * What must also be equal for two entries to be unified: the
+   * qualified names under which a class or an enum is declared.
+   */
+  std::string key;
+  /*! The entries referred to, in the order of \c \\x02. */
+  std::vector<unsigned> refs;
+  bool isNns;
+};
+
+/*!
+ * \brief The tables and the global symbols of one or more XcodeML
+ * documents, with structurally identical entries unified.
+ *
+ * Two entries are unified if their elements are equal after replacing
+ * identifiers with the entries they refer to (recursively, so that
+ * recursive types are handled), and, for class, struct, union and enum
+ * types, if they are declared under the same qualified names. A tagged
+ * type that its document never declares is not unified with types of
+ * other documents.
+ */
+struct LinkUnit {
+  std::vector<LinkEntry> entries;
+  /*! The global symbols; \c isNns and \c key are unused. */
+  std::vector<LinkEntry> symbols;
+  /*!
+   * For each document (in the order of the inputs), the index of the
+   * entry in \c entries that each entry of its tables has become.
+   */
+  std::vector<std::vector<unsigned>> documents;
+};
+
+std::vector<xmlNodePtr> getTableEntries(xmlDocPtr doc);
+
+LinkUnit makeLinkUnit(xmlDocPtr doc, size_t docIndex);
+
+LinkUnit linkUnits(LinkUnit &&lhs, LinkUnit &&rhs);
+
+LinkUnit linkAll(std::vector<LinkUnit> &&units, unsigned jobs);
+
+std::vector<std::string> makeIdentifiers(const LinkUnit &unit);
+
+std::string instantiateEntry(const LinkEntry &entry,
+    const std::string &identifier,
+    const std::vector<std::string> &identifiers);
+
+void renameIdentifiers(xmlNodePtr node,
+    const std::unordered_map<std::string, std::string> &newNames);
+
+void parallelFor(
+    size_t count, unsigned jobs, const std::function<void(size_t)> &body);
+
+} // namespace XcodeMl
+
+#endif /* !XCODEMLLINKER_H */
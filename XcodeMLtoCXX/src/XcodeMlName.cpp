@@ -3,8 +3,10 @@
 #include <string>
 #include <vector>
 #include <libxml/tree.h>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/Support/Casting.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "XcodeMlType.h"
 #include "XcodeMlEnvironment.h"
@@ -19,9 +21,7 @@ using CXXCodeGen::makeVoidNode;
 
 namespace XcodeMl {
 
-Name::Name(
-    const std::shared_ptr<UnqualId> &id_, const std::shared_ptr<Nns> &nns_)
-    : id(id_), nns(nns_) {
+Name::Name(const UnqualIdRef &id_, const NnsRef &nns_) : id(id_), nns(nns_) {
 }
 
 CodeFragment
@@ -31,11 +31,11 @@ Name::toString(const Environment &typeTable, const NnsMap &nnsTable) const {
       + id->toString(typeTable);
 }
 
-std::shared_ptr<UnqualId>
+UnqualIdRef
 Name::getUnqualId() const {
   assert(id);
   auto pId = id->clone();
-  return std::shared_ptr<UnqualId>(pId);
+  return UnqualIdRef(pId);
 }
 
 UnqualId::UnqualId(UnqualIdKind k) : kind(k) {
@@ -50,6 +50,10 @@ UnqualId::getKind() const {
 }
 
 UIDIdent::UIDIdent(const std::string &id)
+    : UnqualId(UnqualIdKind::Ident), ident(makeTokenNode(id)) {
+}
+
+UIDIdent::UIDIdent(const CodeFragment &id)
     : UnqualId(UnqualIdKind::Ident), ident(id) {
 }
 
@@ -61,7 +65,7 @@ UIDIdent::clone() const {
 
 CodeFragment
 UIDIdent::toString(const Environment &) const {
-  return makeTokenNode(ident);
+  return ident;
 }
 
 bool
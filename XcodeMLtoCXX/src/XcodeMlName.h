@@ -5,6 +5,8 @@ namespace XcodeMl {
 
 class Environment;
 class Nns;
+class UnqualId;
+using UnqualIdRef = llvm::IntrusiveRefCntPtr<UnqualId>;
 
 enum class UnqualIdKind {
   Ident,
@@ -14,7 +16,8 @@ enum class UnqualIdKind {
   Dtor,
 };
 
-class UnqualId {
+class UnqualId : public llvm::RefCountedBase<UnqualId>,
+                 public ArenaAllocated {
 public:
   UnqualId(UnqualIdKind);
   virtual ~UnqualId() = 0;
@@ -34,19 +37,19 @@ private:
  */
 class Name {
 public:
-  explicit Name(
-      const std::shared_ptr<UnqualId> &, const std::shared_ptr<Nns> &);
+  explicit Name(const UnqualIdRef &, const NnsRef &);
   CodeFragment toString(const Environment &, const NnsMap &) const;
-  std::shared_ptr<UnqualId> getUnqualId() const;
+  UnqualIdRef getUnqualId() const;
 
 private:
-  std::shared_ptr<UnqualId> id;
-  std::shared_ptr<Nns> nns;
+  UnqualIdRef id;
+  NnsRef nns;
 };
 
 class UIDIdent : public UnqualId {
 public:
   UIDIdent(const std::string &);
+  UIDIdent(const CodeFragment &);
   ~UIDIdent() override = default;
   UnqualId *clone() const override;
   CodeFragment toString(const Environment &) const override;
@@ -56,7 +59,7 @@ protected:
   UIDIdent(const UIDIdent &) = default;
 
 private:
-  std::string ident;
+  CodeFragment ident;
 };
 
 class OpFuncId : public UnqualId {
@@ -3,8 +3,10 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/Support/Casting.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "Util.h"
 #include "XcodeMlType.h"
@@ -105,19 +107,19 @@ ClassNns::classof(const Nns *N) {
 
 NnsRef
 makeGlobalNns() {
-  return std::make_shared<GlobalNns>();
+  return NnsRef(new GlobalNns());
 }
 
 NnsRef
 makeClassNns(const NnsIdent &ident,
     const NnsRef &parent,
     const DataTypeIdent &classType) {
-  return std::make_shared<ClassNns>(ident, parent, classType);
+  return NnsRef(new ClassNns(ident, parent, classType));
 }
 
 NnsRef
 makeClassNns(const NnsIdent &ident, const DataTypeIdent &classType) {
-  return std::make_shared<ClassNns>(ident, nullptr, classType);
+  return NnsRef(new ClassNns(ident, nullptr, classType));
 }
 
 } // namespace XcodeMl
@@ -4,7 +4,7 @@
 namespace XcodeMl {
 
 class Nns;
-using NnsRef = std::shared_ptr<Nns>;
+using NnsRef = llvm::IntrusiveRefCntPtr<Nns>;
 
 using CodeFragment = CXXCodeGen::StringTreeRef;
 
@@ -23,7 +23,7 @@ enum class NnsKind {
   Class,
 };
 
-class Nns {
+class Nns : public llvm::RefCountedBase<Nns>, public ArenaAllocated {
 public:
   Nns(NnsKind, const NnsRef &, const NnsIdent &);
   Nns(NnsKind, const NnsIdent &, const NnsIdent &);
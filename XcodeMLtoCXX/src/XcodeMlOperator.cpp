@@ -5,8 +5,10 @@
 #include <vector>
 #include <libxml/debugXML.h>
 #include <libxml/tree.h>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "LibXMLUtil.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "Util.h"
 #include "XcodeMlNns.h"
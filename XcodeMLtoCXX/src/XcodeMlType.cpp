@@ -5,7 +5,9 @@
 #include <string>
 #include <vector>
 #include <libxml/tree.h>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "XcodeMlType.h"
 #include "XcodeMlNns.h"
@@ -96,7 +98,8 @@ Type::getKind() const {
 }
 
 Type::Type(const Type &other)
-    : kind(other.kind),
+    : llvm::RefCountedBase<Type>(),
+      kind(other.kind),
       ident(other.ident),
       constness(other.constness),
       volatility(other.volatility) {
@@ -733,7 +736,7 @@ makeDecl(TypeRef type, CodeFragment var, const Environment &env) {
 
 TypeRef
 makeReservedType(DataTypeIdent ident, CodeFragment name, bool c, bool v) {
-  auto type = std::make_shared<Reserved>(ident, name);
+  auto type = TypeRef(new Reserved(ident, name));
   type->setConst(c);
   type->setVolatile(v);
   return type;
@@ -744,22 +747,22 @@ makeQualifiedType(const DataTypeIdent &ident,
     const DataTypeIdent &underlyingType,
     bool c,
     bool v) {
-  return std::make_shared<QualifiedType>(ident, underlyingType, c, v);
+  return TypeRef(new QualifiedType(ident, underlyingType, c, v));
 }
 
 TypeRef
 makePointerType(DataTypeIdent ident, TypeRef ref) {
-  return std::make_shared<Pointer>(ident, ref);
+  return TypeRef(new Pointer(ident, ref));
 }
 
 TypeRef
 makePointerType(DataTypeIdent ident, DataTypeIdent ref) {
-  return std::make_shared<Pointer>(ident, ref);
+  return TypeRef(new Pointer(ident, ref));
 }
 
 TypeRef
 makeLValueReferenceType(const DataTypeIdent &ident, const DataTypeIdent &ref) {
-  return std::make_shared<LValueReferenceType>(ident, ref);
+  return TypeRef(new LValueReferenceType(ident, ref));
 }
 
 TypeRef
@@ -767,56 +770,56 @@ makeFunctionType(DataTypeIdent ident,
     TypeRef returnType,
     const Function::Params &params,
     bool isVariadic) {
-  return std::make_shared<Function>(ident, returnType, params, isVariadic);
+  return TypeRef(new Function(ident, returnType, params, isVariadic));
 }
 
 TypeRef
 makeArrayType(DataTypeIdent ident, TypeRef elemType, size_t size) {
-  return std::make_shared<Array>(ident, elemType->dataTypeIdent(), size);
+  return TypeRef(new Array(ident, elemType->dataTypeIdent(), size));
 }
 
 TypeRef
 makeArrayType(DataTypeIdent ident, DataTypeIdent elemType, size_t size) {
-  return std::make_shared<Array>(ident, elemType, size);
+  return TypeRef(new Array(ident, elemType, size));
 }
 
 TypeRef
 makeArrayType(DataTypeIdent ident, TypeRef elemType, Array::Size size) {
-  return std::make_shared<Array>(ident, elemType->dataTypeIdent(), size);
+  return TypeRef(new Array(ident, elemType->dataTypeIdent(), size));
 }
 
 TypeRef
 makeArrayType(DataTypeIdent ident, DataTypeIdent elemName, Array::Size size) {
-  return std::make_shared<Array>(ident, elemName, size);
+  return TypeRef(new Array(ident, elemName, size));
 }
 
 TypeRef
 makeEnumType(const DataTypeIdent &ident) {
-  return std::make_shared<EnumType>(ident, EnumType::EnumName());
+  return TypeRef(new EnumType(ident, EnumType::EnumName()));
 }
 
 TypeRef
 makeStructType(const DataTypeIdent &ident,
     const CodeFragment &tag,
     const Struct::MemberList &fields) {
-  return std::make_shared<Struct>(ident, tag, fields);
+  return TypeRef(new Struct(ident, tag, fields));
 }
 
 TypeRef
 makeClassType(const DataTypeIdent &ident, const ClassType::Symbols &symbols) {
-  return std::make_shared<ClassType>(ident, symbols);
+  return TypeRef(new ClassType(ident, symbols));
 }
 
 TypeRef
 makeClassType(const DataTypeIdent &ident,
     const std::vector<ClassType::BaseClass> &bases,
     const ClassType::Symbols &symbols) {
-  return std::make_shared<ClassType>(ident, bases, symbols);
+  return TypeRef(new ClassType(ident, bases, symbols));
 }
 
 TypeRef
 makeOtherType(const DataTypeIdent &ident) {
-  return std::make_shared<OtherType>(ident);
+  return TypeRef(new OtherType(ident));
 }
 
 CodeFragment
@@ -4,7 +4,7 @@
 namespace XcodeMl {
 
 class Type;
-using TypeRef = std::shared_ptr<Type>;
+using TypeRef = llvm::IntrusiveRefCntPtr<Type>;
 
 /* data type identifier (3.1 data type identifier) */
 using DataTypeIdent = std::string;
@@ -13,6 +13,7 @@ using CodeFragment = CXXCodeGen::StringTreeRef;
 
 class Environment;
 class UnqualId;
+using UnqualIdRef = llvm::IntrusiveRefCntPtr<UnqualId>;
 
 class MemberDecl {
 public:
@@ -61,7 +62,7 @@ CodeFragment TypeRefToString(TypeRef, const Environment &env);
 /*!
  * \brief A class that represents data types in XcodeML.
  */
-class Type {
+class Type : public llvm::RefCountedBase<Type>, public ArenaAllocated {
 public:
   Type(TypeKind, DataTypeIdent, bool = false, bool = false);
   virtual ~Type() = 0;
@@ -319,7 +320,7 @@ AccessSpec accessSpec_of_string(const std::string &);
 class ClassType : public Type {
 public:
   using ClassName = llvm::Optional<CodeFragment>;
-  using MemberName = std::shared_ptr<UnqualId>;
+  using MemberName = UnqualIdRef;
   using Symbols = std::vector<std::tuple<MemberName, DataTypeIdent>>;
   using BaseClass = std::tuple<std::string, DataTypeIdent, bool>;
   ClassType(const DataTypeIdent &, const CodeFragment &, const Symbols &);
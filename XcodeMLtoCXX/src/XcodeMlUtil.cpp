@@ -1,3 +1,4 @@
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -6,8 +7,10 @@
 #include <libxml/debugXML.h>
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "LibXMLUtil.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "Util.h"
 #include "XcodeMlType.h"
@@ -20,32 +23,50 @@
 
 #include "XcodeMlUtil.h"
 
-std::shared_ptr<XcodeMl::UnqualId>
+/*!
+ * \brief Make a token node of the text content of \c node.
+ *
+ * If the content is a single text node, the token refers to the text
+ * owned by the document instead of copying it, so the result must not
+ * outlive the document.
+ */
+XcodeMl::CodeFragment
+makeContentNode(xmlNodePtr node) {
+  assert(node);
+  const xmlNodePtr text = node->children;
+  if (text && !text->next && text->type == XML_TEXT_NODE && text->content) {
+    const auto content = reinterpret_cast<const char *>(text->content);
+    return CXXCodeGen::makeBorrowedTokenNode(content, std::strlen(content));
+  }
+  return CXXCodeGen::makeTokenNode(getContent(node));
+}
+
+XcodeMl::UnqualIdRef
 getUnqualIdFromNameNode(xmlNodePtr nameNode) {
   const auto kind = getProp(nameNode, "name_kind");
 
   if (kind == "constructor") {
     const auto dtident = getProp(nameNode, "ctor_type");
-    return std::make_shared<XcodeMl::CtorName>(dtident);
+    return XcodeMl::UnqualIdRef(new XcodeMl::CtorName(dtident));
   } else if (kind == "destructor") {
     const auto dtident = getProp(nameNode, "dtor_type");
-    return std::make_shared<XcodeMl::DtorName>(dtident);
+    return XcodeMl::UnqualIdRef(new XcodeMl::DtorName(dtident));
   } else if (kind == "operator") {
     const auto opName = getContent(nameNode);
     const auto pOpId = XcodeMl::OperatorNameToSpelling(opName);
     assert(pOpId.hasValue());
-    return std::make_shared<XcodeMl::OpFuncId>(*pOpId);
+    return XcodeMl::UnqualIdRef(new XcodeMl::OpFuncId(*pOpId));
   } else if (kind == "conversion") {
     const auto dtident = getProp(nameNode, "destination_type");
-    return std::make_shared<XcodeMl::ConvFuncId>(dtident);
+    return XcodeMl::UnqualIdRef(new XcodeMl::ConvFuncId(dtident));
   }
 
   assert(kind == "name");
-  const auto name = getContent(nameNode);
-  return std::make_shared<XcodeMl::UIDIdent>(name);
+  const auto name = makeContentNode(nameNode);
+  return XcodeMl::UnqualIdRef(new XcodeMl::UIDIdent(name));
 }
 
-std::shared_ptr<XcodeMl::UnqualId>
+XcodeMl::UnqualIdRef
 getUnqualIdFromIdNode(xmlNodePtr idNode, xmlXPathContextPtr ctxt) {
   if (!idNode) {
     throw std::domain_error("expected id node, but got null");
@@ -57,11 +78,11 @@ getUnqualIdFromIdNode(xmlNodePtr idNode, xmlXPathContextPtr ctxt) {
   return getUnqualIdFromNameNode(nameNode);
 }
 
-std::shared_ptr<XcodeMl::Nns>
+XcodeMl::NnsRef
 getNns(const XcodeMl::NnsMap &nnsTable, xmlNodePtr nameNode) {
   const auto ident = getPropOrNull(nameNode, "nns");
   if (!ident.hasValue()) {
-    return std::shared_ptr<XcodeMl::Nns>();
+    return XcodeMl::NnsRef();
   }
   const auto nns = getOrNull(nnsTable, *ident);
   if (!nns.hasValue()) {
@@ -7,12 +7,14 @@ class UnqualId;
 
 class SourceInfo;
 
-std::shared_ptr<XcodeMl::UnqualId> getUnqualIdFromNameNode(xmlNodePtr idNode);
+XcodeMl::CodeFragment makeContentNode(xmlNodePtr);
 
-std::shared_ptr<XcodeMl::UnqualId> getUnqualIdFromIdNode(
+XcodeMl::UnqualIdRef getUnqualIdFromNameNode(xmlNodePtr idNode);
+
+XcodeMl::UnqualIdRef getUnqualIdFromIdNode(
     xmlNodePtr nameNode, xmlXPathContextPtr ctxt);
 
-std::shared_ptr<XcodeMl::Nns> getNns(
+XcodeMl::NnsRef getNns(
     const XcodeMl::NnsMap &nnsTable, xmlNodePtr nameNode);
 
 XcodeMl::Name getQualifiedNameFromNameNode(
@@ -0,0 +1,26 @@
+#define BOOST_TEST_MODULE ConversionStats
+#include <boost/test/included/unit_test.hpp>
+#include <sstream>
+#include <string>
+#include "ConversionStats.h"
+
+BOOST_AUTO_TEST_SUITE(conversion_stats)
+
+BOOST_AUTO_TEST_CASE(print_test) {
+  BOOST_TEST_CHECKPOINT("elements are counted by walker and name");
+  ConversionStats::countElement("ProgramBuilder", "varDecl");
+  ConversionStats::countElement("TypeAnalyzer", "pointerType");
+  ConversionStats::countElement("ProgramBuilder", "Var");
+  ConversionStats::countElement("ProgramBuilder", "varDecl");
+  ConversionStats::setTypeCount(3);
+  ConversionStats::setOutputBytes(42);
+  std::stringstream ss;
+  ConversionStats::print(ss, "a\\b.xml");
+  BOOST_CHECK(ss.str()
+      == "{\"source\": \"a\\\\b.xml\", \"elements\": "
+         "{\"ProgramBuilder\": {\"Var\": 1, \"varDecl\": 2}, "
+         "\"TypeAnalyzer\": {\"pointerType\": 1}}, "
+         "\"types\": 3, \"outputBytes\": 42}\n");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,50 @@
+#define BOOST_TEST_MODULE TimeReport
+#include <boost/test/included/unit_test.hpp>
+#include <sstream>
+#include <string>
+#include "TimeReport.h"
+
+namespace {
+
+std::string
+printJson() {
+  std::stringstream ss;
+  TimeReport::print(ss, true);
+  return ss.str();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(time_report)
+
+BOOST_AUTO_TEST_CASE(phase_test) {
+  BOOST_TEST_CHECKPOINT("nothing is recorded until enabled");
+  { PhaseTimer timer("ignored"); }
+  BOOST_CHECK(printJson().find("\"phases\": []") != std::string::npos);
+
+  BOOST_TEST_CHECKPOINT("nested phases are recorded once each");
+  TimeReport::enable();
+  {
+    PhaseTimer outer("outer");
+    { PhaseTimer inner("inner"); }
+    { PhaseTimer inner("inner"); }
+  }
+  const auto json = printJson();
+  BOOST_CHECK(json.find("\"name\": \"ignored\"") == std::string::npos);
+  BOOST_CHECK(json.find("{\"name\": \"inner\"") < json.find("\"outer\""));
+  BOOST_CHECK(json.find("\"count\": 2}, {\"name\": \"outer\"")
+      != std::string::npos);
+  BOOST_CHECK(json.find("\"total\": {\"wall\": ") != std::string::npos);
+
+  BOOST_TEST_CHECKPOINT("the table has a line per phase and the total");
+  std::stringstream ss;
+  TimeReport::print(ss, false);
+  std::string line;
+  int lines = 0;
+  while (std::getline(ss, line)) {
+    ++lines;
+  }
+  BOOST_CHECK(lines == 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
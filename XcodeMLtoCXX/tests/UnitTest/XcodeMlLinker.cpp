@@ -0,0 +1,143 @@
+#define BOOST_TEST_MODULE XcodeMl::Linker
+#include <boost/test/included/unit_test.hpp>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include "XcodeMlLinker.h"
+
+namespace {
+
+xmlDocPtr
+parse(const std::string &xml) {
+  return xmlReadMemory(
+      xml.data(), xml.size(), "", nullptr, XML_PARSE_NOBLANKS);
+}
+
+XcodeMl::LinkUnit
+makeUnit(const std::string &xml, size_t docIndex) {
+  xmlDocPtr doc = parse(xml);
+  auto unit = XcodeMl::makeLinkUnit(doc, docIndex);
+  xmlFreeDoc(doc);
+  return unit;
+}
+
+XcodeMl::LinkUnit
+link(const std::vector<std::string> &documents) {
+  std::vector<XcodeMl::LinkUnit> units;
+  for (size_t i = 0; i < documents.size(); ++i) {
+    units.push_back(makeUnit(documents[i], i));
+  }
+  return XcodeMl::linkAll(std::move(units), 2);
+}
+
+std::string
+classDocument(const std::string &name, const std::string &member) {
+  return "<XcodeProgram><typeTable>"
+         "<pointerType type=\"p_" + name + "\" ref=\"c_" + name + "\"/>"
+         "<classType type=\"c_" + name + "\">"
+         "<symbols><id type=\"" + member + "\"><name>m</name></id>"
+         "</symbols></classType>"
+         "</typeTable><globalSymbols>"
+         "<id sclass=\"class_name\" type=\"c_" + name + "\">"
+         "<name>" + name + "</name></id>"
+         "</globalSymbols></XcodeProgram>";
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(xcodeml_linker)
+
+BOOST_AUTO_TEST_CASE(unify_test) {
+  BOOST_TEST_CHECKPOINT("identical types of two documents are unified");
+  const auto unit = link({
+      "<XcodeProgram><typeTable>"
+      "<pointerType type=\"P1\" ref=\"int\"/>"
+      "<pointerType type=\"P2\" ref=\"P1\"/>"
+      "</typeTable><globalSymbols>"
+      "<id sclass=\"extern_def\" type=\"P2\"><name>x</name></id>"
+      "</globalSymbols></XcodeProgram>",
+      "<XcodeProgram><typeTable>"
+      "<pointerType type=\"Q\" ref=\"Q1\"/>"
+      "<pointerType type=\"Q1\" ref=\"int\"/>"
+      "<pointerType type=\"Q2\" ref=\"char\"/>"
+      "</typeTable><globalSymbols>"
+      "<id sclass=\"extern_def\" type=\"Q\"><name>x</name></id>"
+      "</globalSymbols></XcodeProgram>",
+  });
+  BOOST_CHECK(unit.entries.size() == 3);
+  BOOST_CHECK(unit.symbols.size() == 1);
+  BOOST_REQUIRE(unit.documents.size() == 2);
+  BOOST_CHECK(unit.documents[0][0] == unit.documents[1][1]);
+  BOOST_CHECK(unit.documents[0][1] == unit.documents[1][0]);
+  BOOST_CHECK(unit.documents[1][2] != unit.documents[0][0]);
+
+  const auto identifiers = XcodeMl::makeIdentifiers(unit);
+  const auto p2 = unit.documents[0][1];
+  BOOST_CHECK(XcodeMl::instantiateEntry(
+                  unit.entries[p2], identifiers[p2], identifiers)
+      == "<pointerType type=\"" + identifiers[p2] + "\" ref=\""
+          + identifiers[unit.documents[0][0]] + "\"/>");
+  BOOST_CHECK(identifiers[p2].compare(0, 7, "Pointer") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(tagged_type_test) {
+  BOOST_TEST_CHECKPOINT("classes are unified only under the same name");
+  const auto unit = link({
+      classDocument("A", "int"),
+      classDocument("A", "int"),
+      classDocument("B", "int"),
+  });
+  BOOST_CHECK(unit.entries.size() == 4);
+  BOOST_CHECK(unit.documents[0] == unit.documents[1]);
+  BOOST_CHECK(unit.documents[0][1] != unit.documents[2][1]);
+  BOOST_CHECK(unit.symbols.size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(undeclared_tagged_type_test) {
+  BOOST_TEST_CHECKPOINT("classes without names are kept apart");
+  const std::string document = "<XcodeProgram><typeTable>"
+                               "<structType type=\"S\"/>"
+                               "</typeTable></XcodeProgram>";
+  const auto unit = link({document, document});
+  BOOST_CHECK(unit.entries.size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(recursive_type_test) {
+  BOOST_TEST_CHECKPOINT("recursive types are unified");
+  const auto node = [](const std::string &c, const std::string &p) {
+    return "<XcodeProgram><typeTable>"
+           "<classType type=\"" + c + "\"><symbols>"
+           "<id type=\"" + p + "\"><name>next</name></id>"
+           "</symbols></classType>"
+           "<pointerType type=\"" + p + "\" ref=\"" + c + "\"/>"
+           "</typeTable><globalSymbols>"
+           "<id sclass=\"class_name\" type=\"" + c + "\">"
+           "<name>Node</name></id>"
+           "</globalSymbols></XcodeProgram>";
+  };
+  const auto unit = link({node("C1", "P1"), node("C2", "P2")});
+  BOOST_CHECK(unit.entries.size() == 2);
+  BOOST_CHECK(unit.documents[0] == unit.documents[1]);
+}
+
+BOOST_AUTO_TEST_CASE(rename_test) {
+  BOOST_TEST_CHECKPOINT("renameIdentifiers replaces attribute values");
+  xmlDocPtr doc = parse("<varDecl type=\"P1\"><name>P1</name>"
+                        "<value><intConstant type=\"int\">1</intConstant>"
+                        "</value></varDecl>");
+  XcodeMl::renameIdentifiers(
+      xmlDocGetRootElement(doc), {{"P1", "Pointer0"}});
+  xmlBufferPtr buffer = xmlBufferCreate();
+  xmlNodeDump(buffer, doc, xmlDocGetRootElement(doc), 0, 0);
+  const std::string xml(
+      reinterpret_cast<const char *>(xmlBufferContent(buffer)));
+  BOOST_CHECK(xml.find("<varDecl type=\"Pointer0\"><name>P1</name>")
+      == 0);
+  xmlBufferFree(buffer);
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
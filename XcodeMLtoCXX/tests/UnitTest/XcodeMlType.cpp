@@ -4,8 +4,10 @@
 #include <string>
 #include <vector>
 #include <libxml/tree.h>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/Support/Casting.h"
+#include "Arena.h"
 #include "StringTree.h"
 #include "XcodeMlType.h"
 #include "XcodeMlEnvironment.h"
@@ -0,0 +1,78 @@
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+#include "TimeReport.h"
+
+bool TimeReport::enabled = false;
+PhaseTimer *PhaseTimer::current = nullptr;
+
+namespace {
+
+struct Phase {
+  const char *name;
+  double wall;
+  double cpu;
+  unsigned long count;
+};
+
+std::vector<Phase> phases;
+std::chrono::steady_clock::time_point wallStart;
+std::clock_t cpuStart;
+
+} // namespace
+
+void
+TimeReport::enable() {
+  enabled = true;
+  wallStart = std::chrono::steady_clock::now();
+  cpuStart = std::clock();
+}
+
+void
+TimeReport::add(const char *phase, double wall, double cpu) {
+  // There are a few phases, so a linear search is enough.
+  for (auto &p : phases) {
+    if (p.name == phase || std::strcmp(p.name, phase) == 0) {
+      p.wall += wall;
+      p.cpu += cpu;
+      ++p.count;
+      return;
+    }
+  }
+  phases.push_back({phase, wall, cpu, 1});
+}
+
+void
+TimeReport::print(std::ostream &os, bool json) {
+  const std::chrono::duration<double> totalWall =
+      std::chrono::steady_clock::now() - wallStart;
+  const double totalCpu =
+      static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os << std::fixed << std::setprecision(6);
+  if (json) {
+    os << "{\"phases\": [";
+    for (size_t i = 0; i < phases.size(); ++i) {
+      const auto &p = phases[i];
+      os << (i == 0 ? "" : ", ") << "{\"name\": \"" << p.name
+         << "\", \"wall\": " << p.wall << ", \"cpu\": " << p.cpu
+         << ", \"count\": " << p.count << "}";
+    }
+    os << "], \"total\": {\"wall\": " << totalWall.count()
+       << ", \"cpu\": " << totalCpu << "}}" << std::endl;
+  } else {
+    os << "      wall (s)        cpu (s)   count  phase" << std::endl;
+    for (const auto &p : phases) {
+      os << std::setw(14) << p.wall << " " << std::setw(14) << p.cpu << " "
+         << std::setw(7) << p.count << "  " << p.name << std::endl;
+    }
+    os << std::setw(14) << totalWall.count() << " " << std::setw(14)
+       << totalCpu << "          total" << std::endl;
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
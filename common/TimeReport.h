@@ -0,0 +1,87 @@
+#ifndef TIMEREPORT_H
+#define TIMEREPORT_H
+
+#include <chrono>
+#include <ctime>
+#include <iosfwd>
+
+/*!
+ * \brief The wall-clock and CPU time of the phases of a run
+ * (`--time-report`).
+ *
+ * A phase that runs several times is reported once with the total, in
+ * the order the phases first ended. The time of a phase excludes that of
+ * the phases run within it, so the phases add up to the measured part
+ * of the run.
+ */
+class TimeReport {
+public:
+  /*! \brief Starts recording; until then PhaseTimer does nothing. */
+  static void enable();
+  static bool
+  isEnabled() {
+    return enabled;
+  }
+  static void add(const char *phase, double wall, double cpu);
+  /*!
+   * \brief Prints the phases and the total since `enable`, as JSON if
+   * `json` is true and as a table otherwise.
+   */
+  static void print(std::ostream &os, bool json);
+
+private:
+  static bool enabled;
+};
+
+/*!
+ * \brief Measures the time from its construction to its destruction as
+ * the phase \c phase, which must be a string literal.
+ *
+ * When TimeReport is not enabled, it costs only a test. Timers are
+ * used on the main thread only.
+ */
+class PhaseTimer {
+public:
+  explicit PhaseTimer(const char *phase)
+      : phase(TimeReport::isEnabled() ? phase : nullptr),
+        outer(current),
+        nestedWall(0),
+        nestedCpu(0) {
+    if (this->phase) {
+      current = this;
+      wallStart = std::chrono::steady_clock::now();
+      cpuStart = std::clock();
+    }
+  }
+  PhaseTimer(const PhaseTimer &) = delete;
+  PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+  ~PhaseTimer() {
+    if (!phase) {
+      return;
+    }
+    const std::chrono::duration<double> wall =
+        std::chrono::steady_clock::now() - wallStart;
+    const double cpu =
+        static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    TimeReport::add(phase, wall.count() - nestedWall, cpu - nestedCpu);
+    if (outer) {
+      outer->nestedWall += wall.count();
+      outer->nestedCpu += cpu;
+    }
+    current = outer;
+  }
+
+private:
+  /*! the innermost running timer */
+  static PhaseTimer *current;
+
+  const char *phase;
+  PhaseTimer *outer;
+  double nestedWall;
+  double nestedCpu;
+  std::chrono::steady_clock::time_point wallStart;
+  std::clock_t cpuStart;
+};
+
+#endif /* !TIMEREPORT_H */